@@ -5,6 +5,9 @@
     The provided LVGL library file must be installed first
 ******************************************************************************/
 #include "LVGL_Driver.h"
+#include "stage_timer.h"
+#include "heap_stats.h"
+#include "freertos/semphr.h"
 
 lv_disp_drv_t disp_drv;
 
@@ -25,13 +28,65 @@ void Lvgl_print(const char * buf)
     // Serial.flush();
 }
 
+#if LVGL_RENDER_MODE == LVGL_RENDER_DIRECT
+static SemaphoreHandle_t vsync_sem = NULL;
+
+/* Frame buffer switches take effect at the end of the frame being scanned out */
+static bool Lvgl_On_Vsync(esp_lcd_panel_handle_t panel, const esp_lcd_rgb_panel_event_data_t *event_data, void *user_data)
+{
+  BaseType_t high_task_awoken = pdFALSE;
+  xSemaphoreGiveFromISR(vsync_sem, &high_task_awoken);
+  return high_task_awoken == pdTRUE;
+}
+
+/*  Direct mode only redraws the invalidated areas, into whichever frame buffer is
+    not on screen. Copy those areas into the other buffer too, so it is complete
+    when LVGL draws the next frame into it.
+*/
+static void Lvgl_Sync_Frame_Buffers(const lv_color_t *from, lv_color_t *to)
+{
+  lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+  for (uint16_t i = 0; i < disp->inv_p; i++) {
+    if (disp->inv_area_joined[i]) continue;
+    const lv_area_t *a = &disp->inv_areas[i];
+    size_t row_bytes = lv_area_get_width(a) * sizeof(lv_color_t);
+    for (lv_coord_t y = a->y1; y <= a->y2; y++) {
+      size_t offset = (size_t)y * LVGL_WIDTH + a->x1;
+      memcpy(to + offset, from + offset, row_bytes);
+    }
+  }
+}
+#endif
+
+#if LVGL_RENDER_MODE == LVGL_RENDER_STRIPS
+static uint32_t flush_us = 0;     // Time spent copying strips to the panel, for Lvgl_Bench_Strips
+static uint32_t flush_count = 0;
+#endif
+
 /*  Display flushing 
     Displays LVGL content on the LCD
     This function implements associating LVGL data to the LCD screen
 */
 void Lvgl_Display_LCD( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p )
 {
+  StageScope scope(STAGE_FLUSH);
+#if LVGL_RENDER_MODE == LVGL_RENDER_DIRECT
+  // color_p is a whole panel frame buffer; present it once all areas are drawn
+  if (lv_disp_flush_is_last(disp_drv)) {
+    xSemaphoreTake(vsync_sem, 0);  // Drop a stale vsync
+    // The buffer belongs to the panel, so the driver switches to it instead of copying
+    esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, LVGL_WIDTH, LVGL_HEIGHT, color_p);
+    xSemaphoreTake(vsync_sem, portMAX_DELAY);  // The old buffer is on screen until the switch
+    Lvgl_Sync_Frame_Buffers(color_p, (lv_color_t *)(color_p == buf1 ? buf2 : buf1));
+  }
+#elif LVGL_RENDER_MODE == LVGL_RENDER_STRIPS
+  int64_t start = esp_timer_get_time();
+  LCD_addWindow(area->x1, area->y1, area->x2, area->y2, ( uint8_t *)&color_p->full);
+  flush_us += (uint32_t)(esp_timer_get_time() - start);
+  flush_count++;
+#else
   LCD_addWindow(area->x1, area->y1, area->x2, area->y2, ( uint8_t *)&color_p->full);
+#endif
   lv_disp_flush_ready( disp_drv );
 }
 /*Read the touchpad*/
@@ -60,11 +115,35 @@ void example_increase_lvgl_tick(void *arg)
 void Lvgl_Init(void)
 {
   lv_init();
-  // esp_lcd_rgb_panel_get_frame_buffer(panel_handle, 2, &buf1, &buf2);                                          
-  
-  buf1 = (lv_color_t*) heap_caps_malloc(LVGL_BUF_LEN, MALLOC_CAP_SPIRAM);
-  buf2 = (lv_color_t*) heap_caps_malloc(LVGL_BUF_LEN, MALLOC_CAP_SPIRAM);
+#if LVGL_RENDER_MODE == LVGL_RENDER_DIRECT
+  // Render into the panel's own frame buffers (no separate draw buffers, no copy per frame)
+  esp_lcd_rgb_panel_get_frame_buffer(panel_handle, 2, &buf1, &buf2);
+  vsync_sem = xSemaphoreCreateBinary();
+  esp_lcd_rgb_panel_event_callbacks_t cbs = {};
+#if ESP_PANEL_LCD_RGB_BOUNCE_BUF_SIZE > 0
+  cbs.on_bounce_frame_finish = Lvgl_On_Vsync;   // With bounce buffers the switch happens when a frame is fully copied out
+#else
+  cbs.on_vsync = Lvgl_On_Vsync;
+#endif
+  esp_lcd_rgb_panel_register_event_callbacks(panel_handle, &cbs, NULL);
+  lv_disp_draw_buf_init( &draw_buf, buf1, buf2, ESP_PANEL_LCD_WIDTH * ESP_PANEL_LCD_HEIGHT);
+#elif LVGL_RENDER_MODE == LVGL_RENDER_STRIPS
+  // Blending into internal RAM is much faster than into PSRAM; fall back to PSRAM if it is short
+  buf1 = heap_tag_malloc(HEAP_TAG_LVGL, LVGL_WIDTH * LVGL_STRIP_HEIGHT * sizeof(lv_color_t), LVGL_STRIP_CAPS);
+  buf2 = heap_tag_malloc(HEAP_TAG_LVGL, LVGL_WIDTH * LVGL_STRIP_HEIGHT * sizeof(lv_color_t), LVGL_STRIP_CAPS);
+  if (!buf1 || !buf2) {
+    printf("LVGL : no internal RAM for %d-row strips, using PSRAM\r\n", LVGL_STRIP_HEIGHT);
+    heap_tag_free(buf1);
+    heap_tag_free(buf2);
+    buf1 = heap_tag_malloc(HEAP_TAG_LVGL, LVGL_WIDTH * LVGL_STRIP_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+    buf2 = heap_tag_malloc(HEAP_TAG_LVGL, LVGL_WIDTH * LVGL_STRIP_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+  }
+  lv_disp_draw_buf_init( &draw_buf, buf1, buf2, LVGL_WIDTH * LVGL_STRIP_HEIGHT);
+#else
+  buf1 = (lv_color_t*) heap_tag_malloc(HEAP_TAG_LVGL, LVGL_BUF_LEN, MALLOC_CAP_SPIRAM);
+  buf2 = (lv_color_t*) heap_tag_malloc(HEAP_TAG_LVGL, LVGL_BUF_LEN, MALLOC_CAP_SPIRAM);
   lv_disp_draw_buf_init( &draw_buf, buf1, buf2, ESP_PANEL_LCD_WIDTH * ESP_PANEL_LCD_HEIGHT);                    
+#endif
 
   /*Initialize the display*/
   lv_disp_drv_init( &disp_drv );
@@ -73,6 +152,9 @@ void Lvgl_Init(void)
   disp_drv.ver_res = LVGL_HEIGHT;
   disp_drv.flush_cb = Lvgl_Display_LCD;
   // disp_drv.full_refresh = 1;                                                                                  
+#if LVGL_RENDER_MODE == LVGL_RENDER_DIRECT
+  disp_drv.direct_mode = 1;   // Draw at screen coordinates into the full-screen buffers
+#endif
   disp_drv.draw_buf = &draw_buf;
   disp_drv.user_data = panel_handle;
   lv_disp_drv_register( &disp_drv );
@@ -97,9 +179,58 @@ void Lvgl_Init(void)
   esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer);
   esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000);
 
+}
+/*  Strip benchmark
+    Redraws the whole screen `frames` times with each candidate strip height and
+    prints the average time per frame, split into rendering and flushing.
+    Heights whose buffers do not fit in internal RAM are skipped. Call from the
+    LVGL task; the configured buffers are restored afterwards.
+*/
+void Lvgl_Bench_Strips(int frames)
+{
+#if LVGL_RENDER_MODE == LVGL_RENDER_STRIPS
+  static const int heights[] = { 8, 16, 24, 32, 40, 48, 64, 80, 96, 120 };
+  if (frames < 1) frames = 1;
+  for (int height : heights) {
+    size_t len = LVGL_WIDTH * height * sizeof(lv_color_t);
+    bool configured = height == LVGL_STRIP_HEIGHT;
+    void *a = configured ? buf1 : heap_tag_malloc(HEAP_TAG_LVGL, len, LVGL_STRIP_CAPS);
+    void *b = configured ? buf2 : heap_tag_malloc(HEAP_TAG_LVGL, len, LVGL_STRIP_CAPS);
+    if (!a || !b) {
+      printf("LVGL : strip %3d rows: not enough internal RAM (largest block %u)\r\n", height,
+             (unsigned)heap_caps_get_largest_free_block(LVGL_STRIP_CAPS));
+      heap_tag_free(a);
+      heap_tag_free(b);
+      continue;
+    }
+
+    lv_disp_draw_buf_init(&draw_buf, a, b, LVGL_WIDTH * height);
+    flush_us = 0;
+    flush_count = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < frames; i++) {
+      lv_obj_invalidate(lv_scr_act());
+      lv_refr_now(NULL);
+    }
+    uint32_t total_us = (uint32_t)(esp_timer_get_time() - start);
+    printf("LVGL : strip %3d rows%s: %6u us/frame (render %6u, flush %6u), %u strips/frame\r\n", height,
+           configured ? "*" : " ", (unsigned)(total_us / frames), (unsigned)((total_us - flush_us) / frames),
+           (unsigned)(flush_us / frames), (unsigned)(flush_count / frames));
+
+    if (!configured) {
+      heap_tag_free(a);
+      heap_tag_free(b);
+    }
+  }
+  lv_disp_draw_buf_init(&draw_buf, buf1, buf2, LVGL_WIDTH * LVGL_STRIP_HEIGHT);
+  lv_obj_invalidate(lv_scr_act());
+#else
+  printf("LVGL : strip benchmark needs LVGL_RENDER_MODE == LVGL_RENDER_STRIPS\r\n");
+#endif
 }
 void Lvgl_Loop(void)
 {
+  StageScope scope(STAGE_LVGL);
   lv_timer_handler(); /* let the GUI do its work */
   // delay( 5 );
 }
@@ -2,15 +2,40 @@
 
 #include <lvgl.h>
 #include "lv_conf.h"
-#include <demos/lv_demos.h>
 #include <esp_heap_caps.h>
+#if defined(ESP_PLATFORM)
+#include <demos/lv_demos.h>
 #include "Display_ST7701.h"
 #include "Touch_GT911.h"
+#else
+// Host build (host/CMakeLists.txt): host/LVGL_Driver_host.cpp renders into an
+// in-memory frame buffer of the panel's size
+#define ESP_PANEL_LCD_WIDTH                       (480)
+#define ESP_PANEL_LCD_HEIGHT                      (480)
+#define ESP_PANEL_LCD_RGB_FRAME_BUF_NUM           (2)
+#endif
 
 #define LVGL_WIDTH     ESP_PANEL_LCD_WIDTH
 #define LVGL_HEIGHT    ESP_PANEL_LCD_HEIGHT
 #define LVGL_BUF_LEN  (LVGL_WIDTH * LVGL_HEIGHT * sizeof(lv_color_t))
 
+// Render modes
+#define LVGL_RENDER_PSRAM_COPY  0   // Two full-screen draw buffers in PSRAM, copied into the panel frame buffer on flush
+#define LVGL_RENDER_DIRECT      1   // LVGL draws straight into the panel's two frame buffers; flush swaps them
+#define LVGL_RENDER_STRIPS      2   // Two LVGL_STRIP_HEIGHT-row draw buffers in internal DMA-capable RAM, copied on flush
+#ifndef LVGL_RENDER_MODE
+#define LVGL_RENDER_MODE  LVGL_RENDER_DIRECT
+#endif
+
+#ifndef LVGL_STRIP_HEIGHT
+#define LVGL_STRIP_HEIGHT  40       // Rows per strip buffer (LVGL_RENDER_STRIPS)
+#endif
+#define LVGL_STRIP_CAPS  (MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA)
+
+#if LVGL_RENDER_MODE == LVGL_RENDER_DIRECT && ESP_PANEL_LCD_RGB_FRAME_BUF_NUM != 2
+#error "LVGL_RENDER_DIRECT needs ESP_PANEL_LCD_RGB_FRAME_BUF_NUM == 2"
+#endif
+
 #define EXAMPLE_LVGL_TICK_PERIOD_MS  2
 
 
@@ -22,4 +47,10 @@ void Lvgl_Touchpad_Read( lv_indev_drv_t * indev_drv, lv_indev_data_t * data );
 void example_increase_lvgl_tick(void *arg);
 
 void Lvgl_Init(void);
+void Lvgl_Bench_Strips(int frames);                                                          // Prints full-screen render and flush time per strip height (LVGL_RENDER_STRIPS)
 void Lvgl_Loop(void);
+
+#if !defined(ESP_PLATFORM)
+const lv_color_t *Lvgl_Host_Frame_Buffer(void);                                              // The buffer last presented (LVGL_WIDTH x LVGL_HEIGHT)
+uint32_t Lvgl_Host_Flush_Count(void);                                                        // Areas flushed so far
+#endif
@@ -1,49 +1,130 @@
 #include "base64_utils.h"
-#include <Arduino.h> // For ps_malloc, ps_free
-#include <string.h>  // For strlen
-#include <esp_heap_caps.h> // Added for heap_caps_malloc and heap_caps_free
-
-static const int8_t b64_table[256] = {
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 0-15
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 16-31
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63, // 32-47
-    52,53,54,55,56,57,58,59,60,61,-1,-1,-1, 0,-1,-1, // 48-63
-    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14, // 64-79
-    15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1, // 80-95
-    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40, // 96-111
-    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1, // 112-127
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 128-143
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 144-159
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 160-175
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 176-191
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 192-207
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 208-223
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, // 224-239
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1  // 240-255
+#include <string.h>  // For strlen, memcpy
+#include "psram_pool.h"
+
+// Block decoder: each of the four characters of a 4-character group is looked
+// up in its own table, which already holds the character's 6 bits shifted to
+// their final position in the 3 output bytes (little-endian). A group then
+// decodes with four loads and three ORs, with no shifting accumulator.
+// Invalid characters map to B64_INVALID, whose high bits survive the ORs, so
+// errors are detected once at the end instead of per character.
+
+#define B64_INVALID 0x01FFFFFFu
+
+static constexpr int8_t b64_value(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? (int8_t)(c - 'A')
+         : (c >= 'a' && c <= 'z') ? (int8_t)(c - 'a' + 26)
+         : (c >= '0' && c <= '9') ? (int8_t)(c - '0' + 52)
+         : (c == '+') ? (int8_t)62
+         : (c == '/') ? (int8_t)63
+         : (int8_t)-1;
+}
+
+struct B64Tables {
+    uint32_t d0[256], d1[256], d2[256], d3[256];
 };
 
-int base64_decode(const char* input, uint8_t* output, size_t output_len) {
-    size_t in_len = 0;
-    while (input[in_len] && input[in_len] != '=') in_len++;
-    size_t out_idx = 0;
-    int val = 0, valb = -8;
-    for (size_t i = 0; input[i] && input[i] != '='; ++i) {
-        int8_t c = b64_table[(uint8_t)input[i]];
-        if (c == -1) continue;
-        val = (val << 6) + c;
-        valb += 6;
-        if (valb >= 0) {
-            if (out_idx >= output_len) return -1; // Output buffer too small
-            output[out_idx++] = (uint8_t)((val >> valb) & 0xFF);
-            valb -= 8;
+static constexpr B64Tables make_b64_tables() {
+    B64Tables t = {};
+    for (int c = 0; c < 256; ++c) {
+        int8_t v = b64_value((uint8_t)c);
+        if (v < 0) {
+            t.d0[c] = t.d1[c] = t.d2[c] = t.d3[c] = B64_INVALID;
+            continue;
         }
+        uint32_t u = (uint32_t)v;
+        t.d0[c] = u << 2;                                // byte 0, bits 7..2
+        t.d1[c] = (u >> 4) | ((u & 0x0F) << 12);         // byte 0 bits 1..0, byte 1 bits 7..4
+        t.d2[c] = ((u >> 2) << 8) | ((u & 0x03) << 22);  // byte 1 bits 3..0, byte 2 bits 7..6
+        t.d3[c] = u << 16;                               // byte 2 bits 5..0
+    }
+    return t;
+}
+
+static constexpr B64Tables b64 = make_b64_tables();
+
+static inline uint32_t decode_group(const uint8_t* in) {
+    return b64.d0[in[0]] | b64.d1[in[1]] | b64.d2[in[2]] | b64.d3[in[3]];
+}
+
+static inline void store3(uint8_t* out, uint32_t v) {
+    out[0] = (uint8_t)v;
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)(v >> 16);
+}
+
+// Number of '=' characters at the end of a padded string
+static size_t b64_padding(const char* input, size_t input_len) {
+    if (input_len < 4 || input_len % 4 != 0) return 0;
+    return (input[input_len - 1] == '=') + (input[input_len - 1] == '=' && input[input_len - 2] == '=');
+}
+
+size_t base64_decoded_size(const char* input, size_t input_len) {
+    if (!input || input_len % 4 == 1) return SIZE_MAX;
+    size_t data_len = input_len - b64_padding(input, input_len);
+    return data_len / 4 * 3 + (data_len % 4 ? data_len % 4 - 1 : 0);
+}
+
+int base64_decode_n(const char* input, size_t input_len, uint8_t* output, size_t output_len) {
+    size_t out_size = base64_decoded_size(input, input_len);
+    if (out_size == SIZE_MAX || out_size > output_len || out_size > (size_t)INT32_MAX) return -1;
+
+    // Everything but the last group is full; the last one may carry padding
+    size_t data_len = input_len - b64_padding(input, input_len);
+    size_t full_groups = data_len / 4;
+
+    const uint8_t* in = (const uint8_t*)input;
+    uint8_t* out = output;
+    uint32_t err = 0;
+    size_t g = 0;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Main loop: 4 groups (16 chars -> 12 bytes) per iteration, written with
+    // 32-bit stores whose 4th byte is overwritten by the next group. Stop one
+    // group early so the last store never runs past out_size.
+    for (; g + 5 <= full_groups; g += 4) {
+        uint32_t a = decode_group(in);
+        uint32_t b = decode_group(in + 4);
+        uint32_t c = decode_group(in + 8);
+        uint32_t d = decode_group(in + 12);
+        err |= a | b | c | d;
+        memcpy(out, &a, 4);
+        memcpy(out + 3, &b, 4);
+        memcpy(out + 6, &c, 4);
+        memcpy(out + 9, &d, 4);
+        in += 16;
+        out += 12;
+    }
+#endif
+    for (; g < full_groups; ++g) {
+        uint32_t v = decode_group(in);
+        err |= v;
+        store3(out, v);
+        in += 4;
+        out += 3;
+    }
+
+    // Tail: 2 or 3 data characters (padding already stripped)
+    size_t rem = data_len - full_groups * 4;
+    if (rem) {
+        uint32_t v = b64.d0[in[0]] | b64.d1[in[1]] | (rem > 2 ? b64.d2[in[2]] : 0);
+        err |= v;
+        *out++ = (uint8_t)v;
+        if (rem > 2) *out++ = (uint8_t)(v >> 8);
     }
-    return out_idx;
+
+    if (err & ~0x00FFFFFFu) return -1; // at least one invalid character
+    return (int)(out - output);
+}
+
+int base64_decode(const char* input, uint8_t* output, size_t output_len) {
+    if (!input) return -1;
+    return base64_decode_n(input, strlen(input), output, output_len);
 }
 
-// Decodes a base64 string into a newly allocated PSRAM buffer.
+// Decodes a base64 string into a PSRAM buffer taken from psram_pool.
 // Returns a pointer to the buffer, or nullptr on error.
-// The caller is responsible for freeing the returned buffer using heap_caps_free().
+// The caller is responsible for returning the buffer with psram_pool_free().
 // The out_decoded_len will be set to the length of the decoded data.
 uint8_t* base64_decode_to_psram(const char* input, size_t* out_decoded_len) {
     if (!input || !out_decoded_len) {
@@ -52,31 +133,25 @@ uint8_t* base64_decode_to_psram(const char* input, size_t* out_decoded_len) {
     }
 
     size_t input_len = strlen(input);
-    if (input_len == 0) {
+    // The exact output size is known from the length and padding alone
+    size_t decoded_size = base64_decoded_size(input, input_len);
+    if (input_len == 0 || decoded_size == SIZE_MAX || decoded_size == 0) {
         *out_decoded_len = 0;
         return nullptr;
     }
 
-    // Calculate maximum possible decoded length.
-    // Each 4 base64 chars correspond to 3 bytes. Padding chars adjust this.
-    // A robust formula for max output size: (input_len * 3 + 3) / 4
-    size_t max_decoded_buffer_size = (input_len * 3 + 3) / 4;
-    if (max_decoded_buffer_size == 0 && input_len > 0) { // Should not happen if input_len > 0
-        max_decoded_buffer_size = 1; // Minimal allocation for safety, though logic implies >0
-    }
-
-    uint8_t* decoded_buffer = (uint8_t*)heap_caps_malloc(max_decoded_buffer_size, MALLOC_CAP_SPIRAM); // Changed to heap_caps_malloc
+    uint8_t* decoded_buffer = (uint8_t*)psram_pool_alloc(decoded_size, HEAP_TAG_BASE64);
     if (!decoded_buffer) {
         *out_decoded_len = 0;
-        return nullptr; 
+        return nullptr;
     }
 
-    int bytes_decoded = base64_decode(input, decoded_buffer, max_decoded_buffer_size);
+    int bytes_decoded = base64_decode_n(input, input_len, decoded_buffer, decoded_size);
 
     if (bytes_decoded < 0) {
-        heap_caps_free(decoded_buffer); // Changed to heap_caps_free
+        psram_pool_free(decoded_buffer);
         *out_decoded_len = 0;
-        return nullptr; 
+        return nullptr;
     }
 
     *out_decoded_len = (size_t)bytes_decoded;
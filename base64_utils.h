@@ -1,14 +1,22 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
-#include <Arduino.h> // Added for size_t, and for consistency with .cpp for ps_malloc related functions
+
+// Returns the exact decoded size of a base64 string of input_len characters,
+// taking '=' padding into account, or SIZE_MAX if the length is not valid base64.
+size_t base64_decoded_size(const char* input, size_t input_len);
+
+// Decodes input_len base64 characters into output in a single pass.
+// Unpadded input is accepted; whitespace and other characters are rejected.
+// Returns the number of bytes written to output, or -1 on error.
+int base64_decode_n(const char* input, size_t input_len, uint8_t* output, size_t output_len);
 
 // Decodes base64 input (null-terminated) into output buffer.
 // Returns the number of bytes written to output, or -1 on error.
 int base64_decode(const char* input, uint8_t* output, size_t output_len);
 
-// Decodes a base64 string into a newly allocated PSRAM buffer.
+// Decodes a base64 string into a PSRAM buffer taken from psram_pool.
 // Returns a pointer to the buffer, or nullptr on error.
-// The caller is responsible for freeing the returned buffer using ps_free().
+// The caller is responsible for returning the buffer with psram_pool_free().
 // The decoded_len will be set to the length of the decoded data.
 uint8_t* base64_decode_to_psram(const char* input, size_t* decoded_len);
@@ -0,0 +1,29 @@
+#pragma once
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#else
+#include <mutex>
+#endif
+
+// Lock for short sections of shared state touched from tasks on both cores.
+// On the device it is a FreeRTOS spinlock taken with taskENTER_CRITICAL,
+// which also stops the scheduler and interrupts on the holder's core, so the
+// holder finishes before anyone on either core can spin on it. Keep the
+// sections to a few hundred cycles and never call the heap, logging or
+// anything that blocks inside one. On the host it is a std::mutex.
+class CriticalSection {
+public:
+#if defined(ESP_PLATFORM)
+    void lock() { taskENTER_CRITICAL(&mux_); }
+    void unlock() { taskEXIT_CRITICAL(&mux_); }
+
+private:
+    portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+    void lock() { mutex_.lock(); }
+    void unlock() { mutex_.unlock(); }
+
+private:
+    std::mutex mutex_;
+#endif
+};
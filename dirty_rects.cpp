@@ -0,0 +1,79 @@
+#include "dirty_rects.h"
+
+static int32_t area_of(const DirtyRect& r) {
+    return (int32_t)(r.x2 - r.x1 + 1) * (r.y2 - r.y1 + 1);
+}
+
+static DirtyRect union_of(const DirtyRect& a, const DirtyRect& b) {
+    DirtyRect u;
+    u.x1 = a.x1 < b.x1 ? a.x1 : b.x1;
+    u.y1 = a.y1 < b.y1 ? a.y1 : b.y1;
+    u.x2 = a.x2 > b.x2 ? a.x2 : b.x2;
+    u.y2 = a.y2 > b.y2 ? a.y2 : b.y2;
+    return u;
+}
+
+void dirty_rects_reset(DirtyRects* d, int width, int height) {
+    d->count = 0;
+    d->width = (int16_t)width;
+    d->height = (int16_t)height;
+    d->full = false;
+}
+
+void dirty_rects_add_all(DirtyRects* d) {
+    d->rects[0] = { 0, 0, (int16_t)(d->width - 1), (int16_t)(d->height - 1) };
+    d->count = 1;
+    d->full = true;
+}
+
+void dirty_rects_add(DirtyRects* d, int x1, int y1, int x2, int y2) {
+    if (d->full) return;
+    if (x1 > x2) { int t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { int t = y1; y1 = y2; y2 = t; }
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= d->width) x2 = d->width - 1;
+    if (y2 >= d->height) y2 = d->height - 1;
+    if (x1 > x2 || y1 > y2) return;
+
+    DirtyRect r = { (int16_t)x1, (int16_t)y1, (int16_t)x2, (int16_t)y2 };
+
+    // Absorb every rectangle whose union with r costs nothing extra; a merge
+    // can make r overlap rectangles it missed before, so rescan after each one
+    for (int i = 0; i < d->count;) {
+        DirtyRect u = union_of(r, d->rects[i]);
+        if (area_of(u) <= area_of(r) + area_of(d->rects[i])) {
+            r = u;
+            d->rects[i] = d->rects[--d->count];
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+
+    if (d->count == DIRTY_RECTS_MAX) {
+        // Full: grow the rectangle that needs the least extra area
+        int best = 0;
+        int32_t best_growth = INT32_MAX;
+        for (int i = 0; i < d->count; ++i) {
+            int32_t growth = area_of(union_of(r, d->rects[i])) - area_of(d->rects[i]);
+            if (growth < best_growth) {
+                best_growth = growth;
+                best = i;
+            }
+        }
+        r = union_of(r, d->rects[best]);
+        d->rects[best] = d->rects[--d->count];
+    }
+    d->rects[d->count++] = r;
+
+    if (dirty_rects_area(d) * 100 >= (int32_t)d->width * d->height * DIRTY_RECTS_FULL_PERCENT) {
+        dirty_rects_add_all(d);
+    }
+}
+
+int32_t dirty_rects_area(const DirtyRects* d) {
+    int32_t total = 0;
+    for (int i = 0; i < d->count; ++i) total += area_of(d->rects[i]);
+    return total;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// Accumulates the bounding boxes touched while drawing a frame and keeps them
+// as a small set of rectangles, so only those areas need to be invalidated
+// and flushed.
+//
+// Rectangles that overlap enough that their union is no larger than the two
+// separately are merged. When the set is full, the new box is merged into the
+// rectangle it grows least. Once the rectangles cover most of the bounds they
+// collapse into a single full-size rectangle.
+
+#define DIRTY_RECTS_MAX 8
+#define DIRTY_RECTS_FULL_PERCENT 60 // Coverage above which the whole bounds are used
+
+struct DirtyRect {
+    int16_t x1, y1, x2, y2; // Inclusive, like lv_area_t
+};
+
+struct DirtyRects {
+    DirtyRect rects[DIRTY_RECTS_MAX];
+    int count;
+    int16_t width, height; // Bounds; boxes are clipped to them
+    bool full;
+};
+
+void dirty_rects_reset(DirtyRects* d, int width, int height);
+
+// Adds the inclusive box (x1, y1)-(x2, y2); coordinates may be in any order and out of bounds.
+void dirty_rects_add(DirtyRects* d, int x1, int y1, int x2, int y2);
+
+// Marks the whole bounds dirty.
+void dirty_rects_add_all(DirtyRects* d);
+
+// Total area of the rectangles in pixels.
+int32_t dirty_rects_area(const DirtyRects* d);
@@ -0,0 +1,78 @@
+#include "disc_splat.h"
+#include <math.h>
+#include "rgb565_blend.h"
+
+#define SPAN_TABLE_SIZE ((DISC_SPLAT_MAX_RADIUS + 1) * (DISC_SPLAT_MAX_RADIUS + 2) / 2)
+
+// Row dy of radius r is at index r * (r + 1) / 2 + dy
+static uint8_t span_half[SPAN_TABLE_SIZE];  // Fully covered pixels on each side of the centre
+static uint8_t span_edge[SPAN_TABLE_SIZE];  // Coverage (0..255) of the pixel at half + 1
+static bool span_built[DISC_SPLAT_MAX_RADIUS + 1];
+
+// Tables are built the first time a radius is drawn
+static int span_index(int r) {
+    int base = r * (r + 1) / 2;
+    if (!span_built[r]) {
+        float outer = (r + 0.5f) * (r + 0.5f);
+        for (int dy = 0; dy <= r; ++dy) {
+            // Half chord of the circle of radius r + 0.5 at this row; pixels
+            // cover [dx - 0.5, dx + 0.5], and the chord is always >= 0.5
+            float c = sqrtf(outer - (float)(dy * dy));
+            int half = (int)(c - 0.5f);
+            span_half[base + dy] = (uint8_t)half;
+            span_edge[base + dy] = (uint8_t)((c - 0.5f - half) * 255.0f + 0.5f);
+        }
+        span_built[r] = true;
+    }
+    return base;
+}
+
+void disc_splat_build_tables() {
+    for (int r = 0; r <= DISC_SPLAT_MAX_RADIUS; ++r) span_index(r);
+}
+
+static inline void blend_pixel(uint16_t* p, uint16_t color, uint32_t a) {
+    if (a) *p = rgb565_blend_pixel(*p, color, a);
+}
+
+void disc_splat_draw(uint16_t* dst, int stride, int clip_x1, int clip_y1, int clip_x2, int clip_y2,
+                     const DiscSplat* discs, int count) {
+    if (clip_x1 > clip_x2 || clip_y1 > clip_y2) return;
+
+    for (int i = 0; i < count; ++i) {
+        const DiscSplat& d = discs[i];
+        if (d.opa == 0) continue;
+        int r = d.radius > DISC_SPLAT_MAX_RADIUS ? DISC_SPLAT_MAX_RADIUS : d.radius;
+        // The edge pixel can reach r + 1 columns out
+        int bx1 = d.x - r - 1, bx2 = d.x + r + 1;
+        int by1 = d.y - r, by2 = d.y + r;
+        if (bx2 < clip_x1 || bx1 > clip_x2 || by2 < clip_y1 || by1 > clip_y2) continue;
+        bool inside = bx1 >= clip_x1 && bx2 <= clip_x2 && by1 >= clip_y1 && by2 <= clip_y2;
+
+        const uint8_t* half = span_half + span_index(r);
+        const uint8_t* edge = span_edge + (half - span_half);
+
+        int y_start = inside ? by1 : (by1 < clip_y1 ? clip_y1 : by1);
+        int y_end = inside ? by2 : (by2 > clip_y2 ? clip_y2 : by2);
+        for (int y = y_start; y <= y_end; ++y) {
+            int dy = y < d.y ? d.y - y : y - d.y;
+            int h = half[dy];
+            uint32_t ea = (d.opa * edge[dy] + 1024u) >> 11; // Edge alpha, 0..32
+            int x1 = d.x - h, x2 = d.x + h;
+            uint16_t* row = dst + (int32_t)y * stride;
+
+            if (inside) {
+                rgb565_fill_alpha(row + x1, x2 - x1 + 1, d.color, d.opa);
+                blend_pixel(row + x1 - 1, d.color, ea);
+                blend_pixel(row + x2 + 1, d.color, ea);
+                continue;
+            }
+
+            int cx1 = x1 < clip_x1 ? clip_x1 : x1;
+            int cx2 = x2 > clip_x2 ? clip_x2 : x2;
+            if (cx1 <= cx2) rgb565_fill_alpha(row + cx1, cx2 - cx1 + 1, d.color, d.opa);
+            if (x1 - 1 >= clip_x1 && x1 - 1 <= clip_x2) blend_pixel(row + x1 - 1, d.color, ea);
+            if (x2 + 1 >= clip_x1 && x2 + 1 <= clip_x2) blend_pixel(row + x2 + 1, d.color, ea);
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+// Batched filled-disc renderer for RGB565 buffers, used by the pointillist
+// layers instead of one lv_canvas_draw_rect call per dot.
+//
+// Each radius has a precomputed span table: for every row offset from the
+// centre, the half-width of the fully covered run and the coverage of the
+// pixel just past it (horizontal anti-aliasing). Drawing a disc is then one
+// fill or blend per row. Discs that lie inside the clip rectangle, which is
+// nearly all of them, skip clipping entirely.
+
+#define DISC_SPLAT_MAX_RADIUS 127 // Larger radii are clamped
+
+struct DiscSplat {
+    int16_t x, y;    // Centre
+    uint8_t radius;  // 0 draws a single pixel
+    uint8_t opa;     // 0..255, like lv_opa_t
+    uint16_t color;  // RGB565
+};
+
+// Draws count discs into dst (pixel (0, 0) at dst, stride in pixels), clipped
+// to the inclusive rectangle (clip_x1, clip_y1)-(clip_x2, clip_y2).
+void disc_splat_draw(uint16_t* dst, int stride, int clip_x1, int clip_y1, int clip_x2, int clip_y2,
+                     const DiscSplat* discs, int count);
+
+// Builds the span tables for every radius. They are otherwise built the first
+// time a radius is drawn, so call this before drawing from more than one task.
+void disc_splat_build_tables();
@@ -0,0 +1,384 @@
+#include "display_list.h"
+#include <math.h>
+#include <string.h>
+#include "disc_splat.h"
+#include "rgb565_blend.h"
+
+#define MASK_CHUNK 64 // Coverage is computed into a stack buffer this many pixels at a time
+
+static_assert(sizeof(DlDisc) <= DISPLAY_LIST_MAX_RECORD_SIZE && sizeof(DlLine) <= DISPLAY_LIST_MAX_RECORD_SIZE &&
+                  sizeof(DlArc) <= DISPLAY_LIST_MAX_RECORD_SIZE && sizeof(DlTriangle) <= DISPLAY_LIST_MAX_RECORD_SIZE,
+              "DISPLAY_LIST_MAX_RECORD_SIZE is too small");
+
+// Per-tile record lists built by display_list_bin, as offsets / 4 into the arena
+static uint16_t tile_start[DISPLAY_LIST_MAX_TILES + 1];
+static uint16_t tile_next[DISPLAY_LIST_MAX_TILES];
+static uint16_t tile_refs[DISPLAY_LIST_MAX_REFS];
+
+static inline int16_t clamp16(int v) {
+    return (int16_t)(v < -32768 ? -32768 : (v > 32767 ? 32767 : v));
+}
+
+static inline int imin(int a, int b) { return a < b ? a : b; }
+static inline int imax(int a, int b) { return a > b ? a : b; }
+
+// Coverage (signed distance into the shape, in pixels, + 0.5) to 0..255
+static inline uint8_t coverage(float c) {
+    if (c <= 0.0f) return 0;
+    if (c >= 1.0f) return 255;
+    return (uint8_t)(c * 255.0f + 0.5f);
+}
+
+void display_list_init(DisplayList* list, void* arena, size_t capacity) {
+    uintptr_t p = (uintptr_t)arena;
+    size_t skip = (4 - (p & 3)) & 3;
+    list->arena = (uint8_t*)(p + skip);
+    list->capacity = arena && capacity > skip ? (capacity - skip) & ~(size_t)3 : 0;
+    display_list_reset(list);
+}
+
+void display_list_reset(DisplayList* list) {
+    list->used = 0;
+    list->count = 0;
+}
+
+// Reserves a record of the given size and fills in its header, or returns nullptr if the arena is full
+static DlHeader* append(DisplayList* list, DisplayListType type, size_t size, uint16_t color, uint8_t opa, int x1,
+                        int y1, int x2, int y2) {
+    size = (size + 3) & ~(size_t)3;
+    if (list->capacity - list->used < size) return nullptr;
+    DlHeader* h = (DlHeader*)(list->arena + list->used);
+    h->type = type;
+    h->size = (uint8_t)size;
+    h->opa = opa;
+    h->reserved = 0;
+    h->color = color;
+    h->x1 = clamp16(x1);
+    h->y1 = clamp16(y1);
+    h->x2 = clamp16(x2);
+    h->y2 = clamp16(y2);
+    list->used += size;
+    list->count++;
+    return h;
+}
+
+bool display_list_disc(DisplayList* list, int x, int y, int radius, uint16_t color, uint8_t opa) {
+    if (opa == 0) return true;
+    radius = imax(0, imin(radius, DISC_SPLAT_MAX_RADIUS));
+    // Same footprint as disc_splat_draw: the edge pixel can reach radius + 1 columns out
+    DlDisc* d = (DlDisc*)append(list, DL_DISC, sizeof(DlDisc), color, opa, x - radius - 1, y - radius, x + radius + 1,
+                                y + radius);
+    if (!d) return false;
+    d->x = clamp16(x);
+    d->y = clamp16(y);
+    d->radius = (uint16_t)radius;
+    return true;
+}
+
+bool display_list_line(DisplayList* list, int ax, int ay, int bx, int by, int width, uint16_t color, uint8_t opa) {
+    if (opa == 0 || width <= 0) return true;
+    // Pixels closer than width / 2 + 0.5 to the segment are covered; this is the
+    // largest integer offset that can be
+    int reach = (int)ceilf(width * 0.5f + 0.5f) - 1;
+    DlLine* l = (DlLine*)append(list, DL_LINE, sizeof(DlLine), color, opa, imin(ax, bx) - reach, imin(ay, by) - reach,
+                                imax(ax, bx) + reach, imax(ay, by) + reach);
+    if (!l) return false;
+    l->ax = clamp16(ax);
+    l->ay = clamp16(ay);
+    l->bx = clamp16(bx);
+    l->by = clamp16(by);
+    l->width = (uint16_t)imin(width, 65535);
+    return true;
+}
+
+bool display_list_arc(DisplayList* list, int cx, int cy, int radius, int width, int start_angle, int end_angle,
+                      uint16_t color, uint8_t opa) {
+    int span = end_angle - start_angle;
+    if (opa == 0 || radius <= 0 || width <= 0 || span == 0) return true; // lv_draw_arc skips start == end too
+    if (span >= 360 || span <= -360) span = 360;
+    else if (span < 0) span += 360;
+    start_angle %= 360;
+    if (start_angle < 0) start_angle += 360;
+    width = imin(width, radius);
+
+    // Bounding box of the sector (centre, the two end points and the axis points
+    // it passes), one pixel wider for the anti-aliased rim and ends
+    float ex = 0.0f, ey = 0.0f, fx = 0.0f, fy = 0.0f;
+    float outer = radius + 1.0f;
+    const int ends[2] = { start_angle, start_angle + span };
+    for (int i = 0; i < 2; ++i) {
+        float a = ends[i] * (3.14159265f / 180.0f);
+        float px = outer * cosf(a), py = outer * sinf(a);
+        ex = fminf(ex, px);
+        ey = fminf(ey, py);
+        fx = fmaxf(fx, px);
+        fy = fmaxf(fy, py);
+    }
+    for (int axis = 0; axis < 720; axis += 90) {
+        if (axis < start_angle || axis > start_angle + span) continue;
+        switch (axis % 360) {
+        case 0: fx = outer; break;
+        case 90: fy = outer; break;
+        case 180: ex = -outer; break;
+        case 270: ey = -outer; break;
+        }
+    }
+    int x1 = imax(cx + (int)floorf(ex) - 1, cx - radius), y1 = imax(cy + (int)floorf(ey) - 1, cy - radius);
+    int x2 = imin(cx + (int)ceilf(fx) + 1, cx + radius), y2 = imin(cy + (int)ceilf(fy) + 1, cy + radius);
+
+    DlArc* a = (DlArc*)append(list, DL_ARC, sizeof(DlArc), color, opa, x1, y1, x2, y2);
+    if (!a) return false;
+    a->cx = clamp16(cx);
+    a->cy = clamp16(cy);
+    a->radius = (uint16_t)imin(radius, 65535);
+    a->width = (uint16_t)imin(width, 65535);
+    a->start_angle = (int16_t)start_angle;
+    a->end_angle = (int16_t)(start_angle + span);
+    return true;
+}
+
+bool display_list_triangle(DisplayList* list, int x0, int y0, int x1, int y1, int x2, int y2, uint16_t color,
+                           uint8_t opa) {
+    if (opa == 0 || (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0) == 0) return true;
+    DlTriangle* t = (DlTriangle*)append(list, DL_TRIANGLE, sizeof(DlTriangle), color, opa, imin(x0, imin(x1, x2)),
+                                        imin(y0, imin(y1, y2)), imax(x0, imax(x1, x2)), imax(y0, imax(y1, y2)));
+    if (!t) return false;
+    t->x[0] = clamp16(x0);
+    t->y[0] = clamp16(y0);
+    t->x[1] = clamp16(x1);
+    t->y[1] = clamp16(y1);
+    t->x[2] = clamp16(x2);
+    t->y[2] = clamp16(y2);
+    return true;
+}
+
+// --- Rasterizers: each draws one record into dst, clipped to (x1, y1)-(x2, y2),
+// which already lies inside the record's bounding box ---
+
+// Blends the span [xa, xb] of one row through the coverage computed by cov(x)
+template <typename Coverage>
+static void blend_span(uint16_t* row, int xa, int xb, const DlHeader* h, Coverage cov) {
+    uint8_t mask[MASK_CHUNK];
+    for (int x = xa; x <= xb; x += MASK_CHUNK) {
+        int n = imin(MASK_CHUNK, xb - x + 1);
+        for (int i = 0; i < n; ++i) mask[i] = cov(x + i);
+        rgb565_fill_mask(row + x, n, h->color, mask, h->opa);
+    }
+}
+
+// Narrows [*xa, *xb] to the x where lo < a * x + b < hi
+static void clip_linear(float a, float b, float lo, float hi, int* xa, int* xb) {
+    if (a == 0.0f) {
+        if (b <= lo || b >= hi) *xb = *xa - 1;
+        return;
+    }
+    float u = (lo - b) / a, v = (hi - b) / a;
+    if (u > v) {
+        float t = u;
+        u = v;
+        v = t;
+    }
+    if (u > (float)*xa) *xa = u > (float)*xb ? *xb + 1 : (int)floorf(u);
+    if (v < (float)*xb) *xb = v < (float)*xa ? *xa - 1 : (int)ceilf(v);
+}
+
+static void draw_disc(const DlDisc* d, uint16_t* dst, int stride, int x1, int y1, int x2, int y2) {
+    DiscSplat s = { d->x, d->y, (uint8_t)d->radius, d->h.opa, d->h.color };
+    disc_splat_draw(dst, stride, x1, y1, x2, y2, &s, 1);
+}
+
+// Capsule: coverage is width / 2 + 0.5 minus the distance to the segment
+static void draw_line(const DlLine* l, uint16_t* dst, int stride, int x1, int y1, int x2, int y2) {
+    float ax = l->ax, ay = l->ay;
+    float dx = (float)(l->bx - l->ax), dy = (float)(l->by - l->ay);
+    float len2 = dx * dx + dy * dy;
+    float inv_len2 = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+    float reach = l->width * 0.5f + 0.5f;
+    float band = reach * sqrtf(len2); // |cross(d, p - a)| below this: within reach of the infinite line
+
+    for (int y = y1; y <= y2; ++y) {
+        float py = y - ay;
+        int xa = x1, xb = x2;
+        if (len2 > 0.0f) clip_linear(dy, -py * dx - dy * ax, -band, band, &xa, &xb);
+        if (xa > xb) continue;
+        blend_span(dst + (int32_t)y * stride, xa, xb, &l->h, [&](int x) {
+            float px = x - ax;
+            float t = (px * dx + py * dy) * inv_len2;
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+            float ex = px - t * dx, ey = py - t * dy;
+            return coverage(reach - sqrtf(ex * ex + ey * ey));
+        });
+    }
+}
+
+// Ring between radius - width and radius with flat ends. Radial coverage is the
+// distance inside the annulus [radius - width + 0.5, radius + 0.5]; the ends
+// are the half-planes bounded by the start and end rays.
+static void draw_arc(const DlArc* a, uint16_t* dst, int stride, int x1, int y1, int x2, int y2) {
+    float outer = a->radius + 0.5f;
+    float inner = a->radius - a->width + 0.5f;
+    int span = a->end_angle - a->start_angle;
+    float sa = a->start_angle * (3.14159265f / 180.0f), ea = a->end_angle * (3.14159265f / 180.0f);
+    float sx = cosf(sa), sy = sinf(sa), ex = cosf(ea), ey = sinf(ea);
+    float hole = a->radius - a->width; // Pixels at most this far from the centre are uncovered
+    float rim = a->radius + 1.0f;      // and so are those at least this far
+
+    for (int y = y1; y <= y2; ++y) {
+        int py = y - a->cy;
+        float r2 = rim * rim - (float)(py * py);
+        if (r2 <= 0.0f) continue;
+        int xo = (int)ceilf(sqrtf(r2));
+        int xi = -1;
+        float h2 = hole * hole - (float)(py * py);
+        if (hole > 0.0f && h2 > 0.0f) xi = (int)floorf(sqrtf(h2)) - 1;
+
+        auto cov = [&](int x) {
+            float px = (float)(x - a->cx), fpy = (float)py;
+            float d = sqrtf(px * px + fpy * fpy);
+            float c = fminf(outer - d, d - inner);
+            if (span < 360) {
+                float s1 = sx * fpy - sy * px; // Distance past the start ray, clockwise
+                float s2 = px * ey - fpy * ex; // Distance before the end ray
+                c = fminf(c, span <= 180 ? fminf(s1, s2) : fmaxf(s1, s2));
+            }
+            return coverage(c + 0.5f);
+        };
+        uint16_t* row = dst + (int32_t)y * stride;
+        // Left and right of the hole
+        int la = imax(x1, a->cx - xo), lb = imin(x2, a->cx - xi - 1);
+        int ra = imax(x1, a->cx + xi + 1), rb = imin(x2, a->cx + xo);
+        if (xi < 0) {
+            if (la <= rb) blend_span(row, la, rb, &a->h, cov);
+            continue;
+        }
+        if (la <= lb) blend_span(row, la, lb, &a->h, cov);
+        if (ra <= rb) blend_span(row, ra, rb, &a->h, cov);
+    }
+}
+
+// Coverage is the smallest signed distance to the three edges, + 0.5
+static void draw_triangle(const DlTriangle* t, uint16_t* dst, int stride, int x1, int y1, int x2, int y2) {
+    float nx[3], ny[3], c[3];
+    int area = (t->x[1] - t->x[0]) * (t->y[2] - t->y[0]) - (t->x[2] - t->x[0]) * (t->y[1] - t->y[0]);
+    for (int i = 0; i < 3; ++i) {
+        int j = i == 2 ? 0 : i + 1;
+        float ex = (float)(t->x[j] - t->x[i]), ey = (float)(t->y[j] - t->y[i]);
+        float s = (area > 0 ? 1.0f : -1.0f) / sqrtf(ex * ex + ey * ey);
+        // Inward normal, so the distance is positive inside
+        nx[i] = -ey * s;
+        ny[i] = ex * s;
+        c[i] = -(nx[i] * t->x[i] + ny[i] * t->y[i]);
+    }
+
+    for (int y = y1; y <= y2; ++y) {
+        float row_c[3];
+        int xa = x1, xb = x2;
+        for (int i = 0; i < 3; ++i) {
+            row_c[i] = ny[i] * y + c[i];
+            clip_linear(nx[i], row_c[i], -0.5f, 1e30f, &xa, &xb);
+        }
+        if (xa > xb) continue;
+        blend_span(dst + (int32_t)y * stride, xa, xb, &t->h, [&](int x) {
+            float d = fminf(nx[0] * x + row_c[0], fminf(nx[1] * x + row_c[1], nx[2] * x + row_c[2]));
+            return coverage(d + 0.5f);
+        });
+    }
+}
+
+static void draw_record(const DlHeader* h, uint16_t* dst, int stride, int x1, int y1, int x2, int y2) {
+    x1 = imax(x1, h->x1);
+    y1 = imax(y1, h->y1);
+    x2 = imin(x2, h->x2);
+    y2 = imin(y2, h->y2);
+    if (x1 > x2 || y1 > y2) return;
+    switch (h->type) {
+    case DL_DISC: draw_disc((const DlDisc*)h, dst, stride, x1, y1, x2, y2); break;
+    case DL_LINE: draw_line((const DlLine*)h, dst, stride, x1, y1, x2, y2); break;
+    case DL_ARC: draw_arc((const DlArc*)h, dst, stride, x1, y1, x2, y2); break;
+    case DL_TRIANGLE: draw_triangle((const DlTriangle*)h, dst, stride, x1, y1, x2, y2); break;
+    }
+}
+
+void display_list_replay_rect(const DisplayList* list, uint16_t* dst, int stride, int x1, int y1, int x2, int y2) {
+    if (x1 > x2 || y1 > y2) return;
+    for (size_t off = 0; off < list->used;) {
+        const DlHeader* h = (const DlHeader*)(list->arena + off);
+        draw_record(h, dst, stride, x1, y1, x2, y2);
+        off += h->size;
+    }
+}
+
+// Tile grid of the last display_list_bin
+static int bin_width, bin_height, bin_tile_h, bin_cols, bin_rows;
+static bool bin_overflow; // Too many record/tile pairs: tiles scan the whole list instead
+
+// Calls fn(tile) for every tile of the grid the record overlaps
+template <typename Visit>
+static void for_each_tile(const DlHeader* h, Visit fn) {
+    if (h->x2 < 0 || h->y2 < 0 || h->x1 >= bin_width || h->y1 >= bin_height) return;
+    int tx1 = imax(h->x1, 0) / DISPLAY_LIST_TILE_W, tx2 = imin(h->x2, bin_width - 1) / DISPLAY_LIST_TILE_W;
+    int ty1 = imax(h->y1, 0) / bin_tile_h, ty2 = imin(h->y2, bin_height - 1) / bin_tile_h;
+    for (int ty = ty1; ty <= ty2; ++ty)
+        for (int tx = tx1; tx <= tx2; ++tx) fn(ty * bin_cols + tx);
+}
+
+int display_list_bin(const DisplayList* list, int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    disc_splat_build_tables(); // Bands may be drawn from several tasks
+    bin_width = width;
+    bin_height = height;
+    bin_cols = (width + DISPLAY_LIST_TILE_W - 1) / DISPLAY_LIST_TILE_W;
+    bin_tile_h = DISPLAY_LIST_TILE_H;
+    while (bin_cols * ((height + bin_tile_h - 1) / bin_tile_h) > DISPLAY_LIST_MAX_TILES) bin_tile_h *= 2;
+    bin_rows = (height + bin_tile_h - 1) / bin_tile_h;
+    int tiles = bin_cols * bin_rows;
+
+    // Count the records overlapping each tile
+    memset(tile_start, 0, (tiles + 1) * sizeof(tile_start[0]));
+    size_t refs = 0;
+    bin_overflow = list->used / 4 > 0xFFFF;
+    for (size_t off = 0; !bin_overflow && off < list->used;) {
+        const DlHeader* h = (const DlHeader*)(list->arena + off);
+        off += h->size;
+        for_each_tile(h, [&](int t) {
+            tile_start[t + 1]++;
+            refs++;
+        });
+        bin_overflow = refs > DISPLAY_LIST_MAX_REFS;
+    }
+    if (bin_overflow) return bin_rows;
+
+    // Fill the bins in drawing order
+    for (int t = 0; t < tiles; ++t) {
+        tile_start[t + 1] += tile_start[t];
+        tile_next[t] = tile_start[t];
+    }
+    for (size_t off = 0; off < list->used;) {
+        const DlHeader* h = (const DlHeader*)(list->arena + off);
+        uint16_t ref = (uint16_t)(off / 4);
+        off += h->size;
+        for_each_tile(h, [&](int t) { tile_refs[tile_next[t]++] = ref; });
+    }
+    return bin_rows;
+}
+
+void display_list_replay_band(const DisplayList* list, uint16_t* dst, int stride, int band) {
+    if (band < 0 || band >= bin_rows) return;
+    int y1 = band * bin_tile_h, y2 = imin(y1 + bin_tile_h, bin_height) - 1;
+    for (int tx = 0; tx < bin_cols; ++tx) {
+        int x1 = tx * DISPLAY_LIST_TILE_W, x2 = imin(x1 + DISPLAY_LIST_TILE_W, bin_width) - 1;
+        if (bin_overflow) {
+            display_list_replay_rect(list, dst, stride, x1, y1, x2, y2);
+            continue;
+        }
+        int t = band * bin_cols + tx;
+        for (int i = tile_start[t]; i < tile_start[t + 1]; ++i)
+            draw_record((const DlHeader*)(list->arena + tile_refs[i] * 4), dst, stride, x1, y1, x2, y2);
+    }
+}
+
+void display_list_replay(const DisplayList* list, uint16_t* dst, int stride, int width, int height) {
+    if (list->count == 0) return;
+    int bands = display_list_bin(list, width, height);
+    for (int b = 0; b < bands; ++b) display_list_replay_band(list, dst, stride, b);
+}
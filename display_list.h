@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-frame display list: the layers record primitives as small POD records
+// in a caller-provided arena, and display_list_replay() rasterizes them into
+// an RGB565 buffer tile by tile, so each tile's pixels stay in cache while
+// every primitive touching it is drawn.
+//
+// Records are appended in drawing order and replayed in that order within
+// each tile, so overlapping primitives blend exactly as if drawn directly.
+// Every record carries its bounding box for culling. Records contain no
+// pointers, so a list can be copied, split or saved as plain bytes.
+//
+// The arena is reused every frame (display_list_reset). When it is full the
+// add functions return false; the caller replays what it has, resets the
+// list and records the primitive again.
+//
+// Coordinates are pixel centres, as in LVGL. Edges are anti-aliased; colours
+// are RGB565 and opacity is 0..255 like lv_opa_t.
+
+#define DISPLAY_LIST_TILE_W 64
+#define DISPLAY_LIST_TILE_H 32
+#define DISPLAY_LIST_MAX_TILES 256 // Tiles grow taller for areas that would need more
+#define DISPLAY_LIST_MAX_REFS 4096 // Record/tile pairs binned per replay; beyond that tiles scan the whole list
+#define DISPLAY_LIST_MAX_RECORD_SIZE 32 // Largest record; at least this much room means any add succeeds
+
+enum DisplayListType : uint8_t {
+    DL_DISC = 0,    // Filled disc (disc_splat.h)
+    DL_LINE,        // Line with round caps
+    DL_ARC,         // Ring segment with flat ends, like lv_draw_arc
+    DL_TRIANGLE,    // Filled triangle
+};
+
+// Common part of every record
+struct DlHeader {
+    uint8_t type;            // DisplayListType
+    uint8_t size;            // Record size in bytes, header included (a multiple of 4)
+    uint8_t opa;
+    uint8_t reserved;
+    uint16_t color;
+    int16_t x1, y1, x2, y2;  // Inclusive bounding box of the pixels the primitive may touch
+};
+
+struct DlDisc {
+    DlHeader h;
+    int16_t x, y;
+    uint16_t radius;
+};
+
+struct DlLine {
+    DlHeader h;
+    int16_t ax, ay, bx, by;
+    uint16_t width;
+};
+
+struct DlArc {
+    DlHeader h;
+    int16_t cx, cy;
+    uint16_t radius;         // Outer radius; the width grows inwards
+    uint16_t width;
+    int16_t start_angle;     // Degrees, 0 = right, clockwise; normalized to 0..359
+    int16_t end_angle;       // start_angle + span, span 1..360
+};
+
+struct DlTriangle {
+    DlHeader h;
+    int16_t x[3], y[3];
+};
+
+struct DisplayList {
+    uint8_t* arena;    // 4-byte aligned
+    size_t capacity;
+    size_t used;
+    uint32_t count;    // Records in the list
+};
+
+void display_list_init(DisplayList* list, void* arena, size_t capacity);
+
+// Drops all records.
+void display_list_reset(DisplayList* list);
+
+// Record a primitive. Return false, recording nothing, if the arena is full.
+// Invisible primitives (zero opacity or size) are accepted and not recorded.
+bool display_list_disc(DisplayList* list, int x, int y, int radius, uint16_t color, uint8_t opa);
+bool display_list_line(DisplayList* list, int ax, int ay, int bx, int by, int width, uint16_t color, uint8_t opa);
+bool display_list_arc(DisplayList* list, int cx, int cy, int radius, int width, int start_angle, int end_angle,
+                      uint16_t color, uint8_t opa);
+bool display_list_triangle(DisplayList* list, int x0, int y0, int x1, int y1, int x2, int y2, uint16_t color,
+                           uint8_t opa);
+
+// Rasterizes the list into dst (pixel (0, 0) at dst, stride in pixels), clipped
+// to width x height, one DISPLAY_LIST_TILE_W x DISPLAY_LIST_TILE_H tile at a time.
+// Same as display_list_bin followed by every band in order.
+void display_list_replay(const DisplayList* list, uint16_t* dst, int stride, int width, int height);
+
+// Bins the records into the tiles of a width x height area and returns the
+// number of bands (rows of tiles) for display_list_replay_band. Only the
+// render task may call this (the bins are static tables).
+int display_list_bin(const DisplayList* list, int width, int height);
+
+// Rasterizes band b of the last display_list_bin, tile by tile. The list must
+// not change in between. Different bands may be drawn concurrently.
+void display_list_replay_band(const DisplayList* list, uint16_t* dst, int stride, int band);
+
+// Rasterizes the records overlapping the inclusive rectangle (x1, y1)-(x2, y2),
+// clipped to it. Safe to call concurrently for disjoint rectangles once
+// disc_splat_build_tables() has run (display_list_bin calls it).
+void display_list_replay_rect(const DisplayList* list, uint16_t* dst, int stride, int x1, int y1, int x2, int y2);
@@ -0,0 +1,109 @@
+#include "frame_scheduler.h"
+#include <stdio.h>
+#include <string.h>
+
+static float smooth(float average, float sample) {
+    return average + FRAME_SCHED_SMOOTHING * (sample - average);
+}
+
+void frame_scheduler_init(FrameScheduler* s, int count, uint32_t budget_us) {
+    memset(s, 0, sizeof(*s));
+    s->count = count < FRAME_SCHED_MAX_LAYERS ? count : FRAME_SCHED_MAX_LAYERS;
+    s->budget_us = budget_us;
+}
+
+void frame_scheduler_set_scalable(FrameScheduler* s, int layer, bool scalable) {
+    if (layer >= 0 && layer < s->count) s->layers[layer].scalable = scalable;
+}
+
+void frame_scheduler_plan(FrameScheduler* s, const int* requested) {
+    float avail = (float)s->budget_us;
+    int open = 0; // Scalable layers still waiting for a share
+    for (int i = 0; i < s->count; ++i) {
+        FrameLayer& l = s->layers[i];
+        l.requested = requested[i] > 0 ? requested[i] : 0;
+        l.granted = l.requested;
+        l.budget_us = 0;
+        if (l.requested == 0) continue;
+        if (!l.scalable || l.unit_us <= 0.0f) {
+            // Fixed layers get what they cost; an unmeasured layer runs in full once to be measured
+            float cost = l.scalable ? 0.0f : l.cost_us;
+            l.budget_us = (uint32_t)cost;
+            avail -= cost;
+        } else {
+            open++;
+        }
+    }
+    if (avail < 0.0f) avail = 0.0f;
+
+    // Layers that need no more than an even share get all they asked for;
+    // their leftovers raise the share of the others
+    bool settled = false;
+    while (open > 0 && !settled) {
+        settled = true;
+        float share = avail / open;
+        for (int i = 0; i < s->count; ++i) {
+            FrameLayer& l = s->layers[i];
+            if (l.requested == 0 || !l.scalable || l.unit_us <= 0.0f || l.budget_us != 0) continue;
+            float need = l.requested * l.unit_us;
+            if (need <= share) {
+                l.budget_us = need < 1.0f ? 1 : (uint32_t)need;
+                avail -= need;
+                open--;
+                settled = false;
+            }
+        }
+    }
+    if (open == 0) return;
+
+    // The rest split what is left and do as much as fits, at least one unit
+    float share = avail / open;
+    for (int i = 0; i < s->count; ++i) {
+        FrameLayer& l = s->layers[i];
+        if (l.requested == 0 || !l.scalable || l.unit_us <= 0.0f || l.budget_us != 0) continue;
+        int units = (int)(share / l.unit_us);
+        l.granted = units < 1 ? 1 : (units > l.requested ? l.requested : units);
+        l.budget_us = share < 1.0f ? 1 : (uint32_t)share;
+    }
+}
+
+void frame_scheduler_measure(FrameScheduler* s, int layer, int units, uint32_t elapsed_us) {
+    if (layer < 0 || layer >= s->count) return;
+    FrameLayer& l = s->layers[layer];
+    bool first = l.cost_us <= 0.0f;
+    l.cost_us = first ? elapsed_us : smooth(l.cost_us, (float)elapsed_us);
+    if (units > 0) {
+        float unit = (float)elapsed_us / units;
+        l.unit_us = l.unit_us <= 0.0f ? unit : smooth(l.unit_us, unit);
+        if (l.unit_us <= 0.0f) l.unit_us = 0.001f; // Measured, just below the timer resolution
+    }
+    s->measured_us += elapsed_us;
+}
+
+void frame_scheduler_end_frame(FrameScheduler* s) {
+    s->frame_us = s->frame_us <= 0.0f ? s->measured_us : smooth(s->frame_us, (float)s->measured_us);
+    s->measured_us = 0;
+}
+
+size_t frame_scheduler_format(const FrameScheduler* s, const char* const* names, uint32_t period_ms, char* buf,
+                              size_t cap) {
+    size_t len = 0;
+    int n = snprintf(buf, cap, "{\"type\":\"sched\",\"period_ms\":%u,\"budget_us\":%u,\"frame_us\":%u,\"layers\":[",
+                     (unsigned)period_ms, (unsigned)s->budget_us, (unsigned)s->frame_us);
+    if (n < 0 || (size_t)n >= cap) return 0;
+    len = n;
+    for (int i = 0; i < s->count; ++i) {
+        const FrameLayer& l = s->layers[i];
+        n = snprintf(buf + len, cap - len,
+                     "%s{\"name\":\"%s\",\"on\":%d,\"budget_us\":%u,\"cost_us\":%u,\"requested\":%d,\"granted\":%d}",
+                     i ? "," : "", names[i], l.requested > 0, (unsigned)l.budget_us, (unsigned)l.cost_us, l.requested,
+                     l.granted);
+        if (n < 0 || (size_t)n >= cap - len) return 0;
+        len += n;
+    }
+    if (cap - len < 3) return 0;
+    buf[len++] = ']';
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-layer time budgets for draw_frame.
+//
+// Every layer reports how long it took and how many units of work it did
+// (r4: dots, r5: grid cells; r1-r3 draw one primitive and are not scalable).
+// The scheduler keeps a moving average of each layer's cost per unit and,
+// before each frame, shares the frame budget out among the enabled layers:
+// fixed layers get what they cost, and the rest is split evenly among the
+// scalable ones, with whatever a layer does not need going to the others.
+// A scalable layer is then granted as many units as fit in its share (at
+// least one), so a costly layer does less per frame instead of stretching
+// the frame.
+
+#define FRAME_SCHED_MAX_LAYERS 8
+#define FRAME_SCHED_SMOOTHING 0.25f // Weight of the newest measurement in the moving averages
+
+struct FrameLayer {
+    bool scalable;      // Work can be cut down to fit the budget
+    int requested;      // Units the layer wants this frame (0: disabled)
+    int granted;        // Units it may do this frame
+    uint32_t budget_us; // Its share of the frame budget
+    float cost_us;      // Moving average of its measured time per frame
+    float unit_us;      // Moving average of its time per unit (0 until measured)
+};
+
+struct FrameScheduler {
+    uint32_t budget_us; // Time the layers may take per frame together
+    int count;
+    float frame_us;     // Moving average of the layers' total time
+    uint32_t measured_us; // Layer time measured since the last plan
+    FrameLayer layers[FRAME_SCHED_MAX_LAYERS];
+};
+
+void frame_scheduler_init(FrameScheduler* s, int count, uint32_t budget_us);
+
+void frame_scheduler_set_scalable(FrameScheduler* s, int layer, bool scalable);
+
+// Starts a frame: requested[i] is the work layer i wants (0 if disabled).
+// Fills in every layer's budget_us and granted.
+void frame_scheduler_plan(FrameScheduler* s, const int* requested);
+
+// Records that a layer did units of work in elapsed_us.
+void frame_scheduler_measure(FrameScheduler* s, int layer, int units, uint32_t elapsed_us);
+
+// Ends the frame; updates frame_us from the layers measured since the plan.
+void frame_scheduler_end_frame(FrameScheduler* s);
+
+// Writes the budgets and measured costs as a {"type":"sched"} JSON message.
+// names[i] labels layer i. Returns the length, or 0 if buf is too small.
+size_t frame_scheduler_format(const FrameScheduler* s, const char* const* names, uint32_t period_ms, char* buf,
+                              size_t cap);
@@ -0,0 +1,206 @@
+#include "heap_stats.h"
+#include "critical_section.h"
+#include <stdio.h>
+#include <esp_heap_caps.h>
+#if defined(ESP_PLATFORM)
+#include <esp_memory_utils.h>
+#endif
+
+// One live allocation; no header in front of the block, so the caller's
+// alignment (DMA, LVGL buffers) is whatever heap_caps gave
+struct TrackedBlock {
+    void* ptr;
+    size_t size;
+    uint8_t tag;
+    uint8_t region;
+};
+
+static const char* const tag_names[HEAP_TAG_COUNT] = { "json", "base64", "image", "canvas", "lvgl", "net" };
+static const char* const region_names[HEAP_REGION_COUNT] = { "internal", "psram" };
+static const uint32_t region_caps[HEAP_REGION_COUNT] = { MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_SPIRAM };
+
+static TrackedBlock blocks[HEAP_STATS_MAX_BLOCKS];
+static HeapTagStats tag_stats[HEAP_TAG_COUNT][HEAP_REGION_COUNT];
+static size_t region_bytes[HEAP_REGION_COUNT];
+static size_t region_peak[HEAP_REGION_COUNT];
+static uint32_t untracked;
+static CriticalSection stats_lock; // Short sections only; heap calls and logging happen outside it
+
+static HeapRegion region_of(const void* ptr, uint32_t caps) {
+#if defined(ESP_PLATFORM)
+    (void)caps;
+    return esp_ptr_external_ram(ptr) ? HEAP_REGION_PSRAM : HEAP_REGION_INTERNAL;
+#else
+    (void)ptr; // One heap on the host: go by what was asked for
+    return (caps & MALLOC_CAP_SPIRAM) ? HEAP_REGION_PSRAM : HEAP_REGION_INTERNAL;
+#endif
+}
+
+static TrackedBlock* find(const void* ptr) {
+    for (int i = 0; i < HEAP_STATS_MAX_BLOCKS; ++i) {
+        if (blocks[i].ptr == ptr) return &blocks[i];
+    }
+    return nullptr;
+}
+
+static void add_bytes(HeapTagStats* s, int region, size_t size) {
+    s->bytes += size;
+    if (s->bytes > s->peak) s->peak = s->bytes;
+    region_bytes[region] += size;
+    if (region_bytes[region] > region_peak[region]) region_peak[region] = region_bytes[region];
+}
+
+static void sub_bytes(HeapTagStats* s, int region, size_t size) {
+    s->bytes -= size;
+    region_bytes[region] -= size;
+}
+
+static void track(HeapTag tag, void* ptr, size_t size, uint32_t caps) {
+    HeapRegion region = region_of(ptr, caps);
+    stats_lock.lock();
+    TrackedBlock* b = find(nullptr);
+    if (b) {
+        *b = { ptr, size, (uint8_t)tag, (uint8_t)region };
+        HeapTagStats* s = &tag_stats[tag][region];
+        s->allocs++;
+        add_bytes(s, region, size);
+    } else {
+        untracked++;
+    }
+    stats_lock.unlock();
+}
+
+static void log_failure(HeapTag tag, size_t size, uint32_t caps) {
+    HeapRegion region = (caps & MALLOC_CAP_SPIRAM) ? HEAP_REGION_PSRAM : HEAP_REGION_INTERNAL;
+    stats_lock.lock();
+    tag_stats[tag][region].failures++;
+    stats_lock.unlock();
+
+    HeapRegionStats r;
+    heap_stats_get_region(region, &r);
+    char line[256];
+    int n = snprintf(line, sizeof(line),
+                     "[Heap] %s: %zu bytes from %s failed (free %u, largest block %u, min free %u; in use:",
+                     tag_names[tag], size, region_names[region], (unsigned)r.free_bytes,
+                     (unsigned)r.largest_free_block, (unsigned)r.min_free_bytes);
+    for (int t = 0; t < HEAP_TAG_COUNT && n > 0 && (size_t)n < sizeof(line); ++t) {
+        HeapTagStats s;
+        heap_stats_get_tag((HeapTag)t, region, &s);
+        if (s.bytes) n += snprintf(line + n, sizeof(line) - n, " %s %u", tag_names[t], (unsigned)s.bytes);
+    }
+    printf("%s)\n", line);
+}
+
+void* heap_tag_malloc(HeapTag tag, size_t size, uint32_t caps) {
+    void* ptr = heap_caps_malloc(size, caps);
+    if (ptr) track(tag, ptr, size, caps);
+    else log_failure(tag, size, caps);
+    return ptr;
+}
+
+void* heap_tag_calloc(HeapTag tag, size_t n, size_t size, uint32_t caps) {
+    void* ptr = heap_caps_calloc(n, size, caps);
+    if (ptr) track(tag, ptr, n * size, caps);
+    else log_failure(tag, n * size, caps);
+    return ptr;
+}
+
+void* heap_tag_realloc(HeapTag tag, void* ptr, size_t size, uint32_t caps) {
+    if (!ptr) return heap_tag_malloc(tag, size, caps);
+    if (size == 0) {
+        heap_tag_free(ptr);
+        return nullptr;
+    }
+    void* moved = heap_caps_realloc(ptr, size, caps);
+    if (!moved) {
+        log_failure(tag, size, caps); // The old block is still valid and still counted
+        return nullptr;
+    }
+
+    HeapRegion region = region_of(moved, caps);
+    stats_lock.lock();
+    TrackedBlock* b = find(ptr);
+    if (b) {
+        sub_bytes(&tag_stats[b->tag][b->region], b->region, b->size);
+        *b = { moved, size, (uint8_t)tag, (uint8_t)region };
+        add_bytes(&tag_stats[tag][region], region, size);
+        stats_lock.unlock();
+    } else {
+        stats_lock.unlock();
+        track(tag, moved, size, caps);
+    }
+    return moved;
+}
+
+void heap_tag_free(void* ptr) {
+    if (!ptr) return;
+    stats_lock.lock();
+    TrackedBlock* b = find(ptr);
+    if (b) {
+        HeapTagStats* s = &tag_stats[b->tag][b->region];
+        s->frees++;
+        sub_bytes(s, b->region, b->size);
+        b->ptr = nullptr;
+    }
+    stats_lock.unlock();
+    heap_caps_free(ptr);
+}
+
+void heap_stats_get_tag(HeapTag tag, HeapRegion region, HeapTagStats* out) {
+    stats_lock.lock();
+    *out = tag_stats[tag][region];
+    stats_lock.unlock();
+}
+
+void heap_stats_get_region(HeapRegion region, HeapRegionStats* out) {
+    stats_lock.lock();
+    out->bytes = region_bytes[region];
+    out->peak = region_peak[region];
+    stats_lock.unlock();
+    out->free_bytes = heap_caps_get_free_size(region_caps[region]);
+    out->min_free_bytes = heap_caps_get_minimum_free_size(region_caps[region]);
+    out->largest_free_block = heap_caps_get_largest_free_block(region_caps[region]);
+}
+
+uint32_t heap_stats_untracked() {
+    stats_lock.lock();
+    uint32_t n = untracked;
+    stats_lock.unlock();
+    return n;
+}
+
+size_t heap_stats_format(char* buf, size_t cap) {
+    size_t len = 0;
+    bool fits = true;
+    auto put = [&](int n) {
+        if (n < 0 || len + (size_t)n >= cap) fits = false;
+        else len += (size_t)n;
+    };
+
+    put(snprintf(buf, cap, "{\"type\":\"heap\",\"regions\":["));
+    for (int r = 0; r < HEAP_REGION_COUNT && fits; ++r) {
+        HeapRegionStats s;
+        heap_stats_get_region((HeapRegion)r, &s);
+        put(snprintf(buf + len, cap - len,
+                     "%s{\"name\":\"%s\",\"bytes\":%u,\"peak\":%u,\"free\":%u,\"min_free\":%u,\"largest_free\":%u}",
+                     r ? "," : "", region_names[r], (unsigned)s.bytes, (unsigned)s.peak, (unsigned)s.free_bytes,
+                     (unsigned)s.min_free_bytes, (unsigned)s.largest_free_block));
+    }
+    if (fits) put(snprintf(buf + len, cap - len, "],\"tags\":["));
+    bool first = true;
+    for (int t = 0; t < HEAP_TAG_COUNT && fits; ++t) {
+        for (int r = 0; r < HEAP_REGION_COUNT && fits; ++r) {
+            HeapTagStats s;
+            heap_stats_get_tag((HeapTag)t, (HeapRegion)r, &s);
+            if (!s.allocs && !s.failures) continue;
+            put(snprintf(buf + len, cap - len,
+                         "%s{\"name\":\"%s\",\"region\":\"%s\",\"bytes\":%u,\"peak\":%u,\"allocs\":%u,\"frees\":%u,"
+                         "\"failed\":%u}",
+                         first ? "" : ",", tag_names[t], region_names[r], (unsigned)s.bytes, (unsigned)s.peak,
+                         (unsigned)s.allocs, (unsigned)s.frees, (unsigned)s.failures));
+            first = false;
+        }
+    }
+    if (fits) put(snprintf(buf + len, cap - len, "],\"untracked\":%u}", (unsigned)heap_stats_untracked()));
+    return fits ? len : 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Tagged wrappers around heap_caps_malloc/free: every large buffer the sketch
+// allocates is counted against the subsystem that asked for it, separately
+// for internal RAM and PSRAM. Per tag and region: bytes currently allocated,
+// their high-water mark, allocation, free and failure counts. Per region:
+// free bytes, the lowest free bytes since boot and the largest free block,
+// from the heap itself. A failed allocation is logged with the region's
+// numbers, so the cause of an out-of-memory after hours of streaming (a leak
+// in one subsystem, or fragmentation) shows in the log.
+//
+// The live blocks are kept in a small fixed table (HEAP_STATS_MAX_BLOCKS);
+// allocations beyond it still work and are counted as untracked. Blocks from
+// psram_pool.h count for the subsystem whose request made the pool allocate
+// them, even while the pool holds them for reuse. All functions are safe to
+// call from any task.
+
+#define HEAP_STATS_MAX_BLOCKS 128
+
+enum HeapTag {
+    HEAP_TAG_JSON,   // ArduinoJson document pools
+    HEAP_TAG_BASE64, // decoded base64 payloads
+    HEAP_TAG_IMAGE,  // decoded image buffers
+    HEAP_TAG_CANVAS, // the canvas and the display list
+    HEAP_TAG_LVGL,   // LVGL draw buffers
+    HEAP_TAG_NET,    // fragment reassembly arena, session trace
+    HEAP_TAG_COUNT
+};
+
+enum HeapRegion {
+    HEAP_REGION_INTERNAL,
+    HEAP_REGION_PSRAM,
+    HEAP_REGION_COUNT
+};
+
+struct HeapTagStats {
+    size_t bytes;      // Currently allocated
+    size_t peak;       // High-water mark of bytes
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;
+};
+
+struct HeapRegionStats {
+    size_t bytes;              // Allocated through the wrappers, all tags
+    size_t peak;
+    size_t free_bytes;         // From the heap: free now
+    size_t min_free_bytes;     // ... lowest since boot
+    size_t largest_free_block; // ... largest single allocation possible now
+};
+
+// heap_caps_malloc/calloc/realloc with the allocation counted against tag.
+// caps as for heap_caps_malloc; MALLOC_CAP_SPIRAM selects the PSRAM region.
+void* heap_tag_malloc(HeapTag tag, size_t size, uint32_t caps);
+void* heap_tag_calloc(HeapTag tag, size_t n, size_t size, uint32_t caps);
+void* heap_tag_realloc(HeapTag tag, void* ptr, size_t size, uint32_t caps);
+
+// Frees a block from heap_tag_malloc/calloc/realloc. nullptr is ignored.
+void heap_tag_free(void* ptr);
+
+void heap_stats_get_tag(HeapTag tag, HeapRegion region, HeapTagStats* out);
+void heap_stats_get_region(HeapRegion region, HeapRegionStats* out);
+
+// Blocks that were allocated while the table was full, and are not counted
+uint32_t heap_stats_untracked();
+
+// Writes the numbers as a {"type":"heap"} JSON message: both regions, and
+// every tag and region that has seen an allocation. Returns the length, or 0
+// if buf is too small. HEAP_STATS_REPORT_MAX always fits: the header, and an
+// entry of at most 128 bytes per region and 136 per tag and region with every
+// count at its 10-digit maximum.
+#define HEAP_STATS_REPORT_MAX (64 + HEAP_REGION_COUNT * 128 + HEAP_TAG_COUNT * HEAP_REGION_COUNT * 136)
+size_t heap_stats_format(char* buf, size_t cap);
@@ -0,0 +1,56 @@
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+static const auto start_time = std::chrono::steady_clock::now();
+static bool clock_simulated = false;
+static unsigned long simulated_us = 0;
+
+unsigned long millis() {
+    if (clock_simulated) return simulated_us / 1000;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                 start_time).count();
+}
+
+unsigned long micros() {
+    if (clock_simulated) return simulated_us;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                                 start_time).count();
+}
+
+void delay(unsigned long ms) {
+    if (clock_simulated) simulated_us += ms * 1000;
+    else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void host_clock_simulate() {
+    clock_simulated = true;
+    simulated_us = 0;
+}
+
+// xorshift32; the ESP32 core uses the hardware RNG instead
+static uint32_t random_state = 2463534242u;
+
+static uint32_t next_random() {
+    uint32_t x = random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return random_state = x;
+}
+
+long random(long howbig) {
+    if (howbig <= 0) return 0;
+    return (long)(next_random() % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+    random_state = seed ? (uint32_t)seed : 2463534242u; // xorshift never leaves 0
+}
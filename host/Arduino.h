@@ -0,0 +1,130 @@
+#pragma once
+// Host stand-in for the parts of the Arduino core the sketch uses: String,
+// Serial (to stdout), millis/micros/delay from the host clock, and a seedable
+// random() so runs are repeatable. The clock can be switched to simulated
+// time, which only moves in delay() (ws_replay.cpp).
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <type_traits>
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    String(int value) : s_(std::to_string(value)) {}
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    bool startsWith(const String& prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s_.size() >= suffix.s_.size() && s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+    }
+    int indexOf(char c) const { size_t i = s_.find(c); return i == std::string::npos ? -1 : (int)i; }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < s_.size() ? String(s_.substr(from, to - from)) : String();
+    }
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s_.c_str(), nullptr); }
+    void trim() {
+        size_t b = s_.find_first_not_of(" \t\r\n");
+        size_t e = s_.find_last_not_of(" \t\r\n");
+        s_ = b == std::string::npos ? std::string() : s_.substr(b, e - b + 1);
+    }
+
+    bool operator==(const String& o) const { return s_ == o.s_; }
+    bool operator!=(const String& o) const { return s_ != o.s_; }
+    bool operator==(const char* o) const { return s_ == o; }
+    bool operator!=(const char* o) const { return s_ != o; }
+    String operator+(const String& o) const { return String(s_ + o.s_); }
+
+private:
+    std::string s_;
+};
+
+class HostSerial {
+public:
+    bool enabled = true; // Cleared to silence the sketch in benchmarks (sketch_host --quiet)
+
+    void begin(unsigned long baud) { (void)baud; }
+    void print(const char* s) { if (enabled) fputs(s, stdout); }
+    void print(const String& s) { print(s.c_str()); }
+    void print(char c) { if (enabled) putchar(c); }
+    void print(long v) { if (enabled) ::printf("%ld", v); }
+    void print(double v) { if (enabled) ::printf("%.2f", v); }
+    void println() { print("\n"); }
+    void println(const char* s) { print(s); println(); }
+    void println(const String& s) { println(s.c_str()); }
+    void println(long v) { print(v); println(); }
+    void println(double v) { print(v); println(); }
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (!enabled) return 0;
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+    void flush() { fflush(stdout); }
+};
+
+extern HostSerial Serial;
+
+#define F(s) (s) // No separate flash address space on the host
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// Switches millis/micros to simulated time starting at 0, advanced only by
+// delay() (which then returns at once), so a run does not depend on how fast
+// the host is.
+void host_clock_simulate();
+
+// The FreeRTOS calls the .ino makes (the ESP32 core's Arduino.h includes
+// FreeRTOS). The host runs the sketch on one thread, so no task is started.
+typedef void* TaskHandle_t;
+static inline void vTaskDelay(uint32_t ticks) { delay(ticks); } // 1 ms ticks, as on the device
+static inline int xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stack, void* arg,
+                                          unsigned priority, TaskHandle_t* handle, int core) {
+    (void)task; (void)name; (void)stack; (void)arg; (void)priority; (void)core;
+    if (handle) *handle = nullptr;
+    return 0;
+}
+
+// Same generator on every host, so a seed reproduces a run
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+static inline int analogRead(int pin) { (void)pin; return 0; }
+
+// The Arduino macros, as templates so mixed int/long arguments still work
+template <typename A, typename B> static inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template <typename A, typename B> static inline typename std::common_type<A, B>::type max(A a, B b) { return a < b ? b : a; }
+template <typename T, typename L, typename H> static inline T constrain(T x, L lo, H hi) {
+    return x < lo ? (T)lo : (x > hi ? (T)hi : x);
+}
+static inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+// glibc before 2.38 has no strlcpy; newlib (ESP32) and the BSDs do
+static inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
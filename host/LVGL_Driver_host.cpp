@@ -0,0 +1,109 @@
+/*****************************************************************************
+  | File        :   LVGL_Driver_host.cpp
+
+  | help        :
+    Host counterpart of LVGL_Driver.cpp for the headless build (CMakeLists.txt
+    in this directory). It uses the device's default render mode,
+    LVGL_RENDER_DIRECT: LVGL draws into one of two full-screen buffers, a flush
+    "presents" that buffer and copies the redrawn areas into the other one.
+    There is no panel; the presented buffer can be read back with
+    Lvgl_Host_Frame_Buffer(). The tick is advanced by the caller (lv_tick_inc).
+******************************************************************************/
+#include "LVGL_Driver.h"
+#include "stage_timer.h"
+#include "heap_stats.h"
+#include <stdio.h>
+#include <string.h>
+
+lv_disp_drv_t disp_drv;
+
+static lv_disp_draw_buf_t draw_buf;
+static lv_color_t *buf1 = NULL;
+static lv_color_t *buf2 = NULL;
+static const lv_color_t *front = NULL; // Buffer "on screen"
+static uint32_t flush_count = 0;
+
+void Lvgl_print(const char * buf)
+{
+  // printf("%s", buf);
+}
+
+/*  Same as on the device: the other buffer gets the areas redrawn this frame,
+    so it is complete when LVGL draws the next frame into it.
+*/
+static void Lvgl_Sync_Frame_Buffers(const lv_color_t *from, lv_color_t *to)
+{
+  lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+  for (uint16_t i = 0; i < disp->inv_p; i++) {
+    if (disp->inv_area_joined[i]) continue;
+    const lv_area_t *a = &disp->inv_areas[i];
+    size_t row_bytes = lv_area_get_width(a) * sizeof(lv_color_t);
+    for (lv_coord_t y = a->y1; y <= a->y2; y++) {
+      size_t offset = (size_t)y * LVGL_WIDTH + a->x1;
+      memcpy(to + offset, from + offset, row_bytes);
+    }
+  }
+}
+
+void Lvgl_Display_LCD( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p )
+{
+  StageScope scope(STAGE_FLUSH);
+  flush_count++;
+  if (lv_disp_flush_is_last(disp_drv)) {
+    front = color_p;
+    Lvgl_Sync_Frame_Buffers(color_p, color_p == buf1 ? buf2 : buf1);
+  }
+  lv_disp_flush_ready( disp_drv );
+}
+
+void Lvgl_Touchpad_Read( lv_indev_drv_t * indev_drv, lv_indev_data_t * data )
+{
+  data->state = LV_INDEV_STATE_REL;
+}
+
+void example_increase_lvgl_tick(void *arg)
+{
+  lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
+}
+
+void Lvgl_Init(void)
+{
+  lv_init();
+  buf1 = (lv_color_t*) heap_tag_calloc(HEAP_TAG_LVGL, LVGL_WIDTH * LVGL_HEIGHT, sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+  buf2 = (lv_color_t*) heap_tag_calloc(HEAP_TAG_LVGL, LVGL_WIDTH * LVGL_HEIGHT, sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+  front = buf1;
+  lv_disp_draw_buf_init( &draw_buf, buf1, buf2, LVGL_WIDTH * LVGL_HEIGHT);
+
+  lv_disp_drv_init( &disp_drv );
+  disp_drv.hor_res = LVGL_WIDTH;
+  disp_drv.ver_res = LVGL_HEIGHT;
+  disp_drv.flush_cb = Lvgl_Display_LCD;
+  disp_drv.direct_mode = 1;
+  disp_drv.draw_buf = &draw_buf;
+  lv_disp_drv_register( &disp_drv );
+
+  lv_obj_t *label = lv_label_create( lv_scr_act() );
+  lv_label_set_text( label, "Hello Ardino and LVGL!");
+  lv_obj_align( label, LV_ALIGN_CENTER, 0, 0 );
+}
+
+void Lvgl_Bench_Strips(int frames)
+{
+  printf("LVGL : strip benchmark needs LVGL_RENDER_MODE == LVGL_RENDER_STRIPS on the device\r\n");
+}
+
+void Lvgl_Loop(void)
+{
+  StageScope scope(STAGE_LVGL);
+  lv_timer_handler();
+}
+
+const lv_color_t *Lvgl_Host_Frame_Buffer(void)
+{
+  return front;
+}
+
+uint32_t Lvgl_Host_Flush_Count(void)
+{
+  return flush_count;
+}
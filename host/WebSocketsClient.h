@@ -0,0 +1,48 @@
+#pragma once
+// Host stand-in for the arduinoWebSockets client. There is no connection:
+// ws_replay.cpp calls webSocketEvent() itself with the events of a recorded
+// trace, and whatever the sketch sends goes to the on_text / on_binary hooks.
+#include "Arduino.h"
+
+// Same values as the library; traces store them (ws_trace.h)
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+class WebSocketsClient {
+public:
+    typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t* payload, size_t length);
+
+    void (*on_text)(const char* msg) = nullptr;
+    void (*on_binary)(const uint8_t* data, size_t len) = nullptr;
+
+    void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino") {
+        (void)host; (void)port; (void)url; (void)protocol;
+    }
+    void onEvent(WebSocketClientEvent cb) { event_ = cb; }
+    void setReconnectInterval(unsigned long ms) { (void)ms; }
+    void loop() {}
+
+    bool sendTXT(const char* msg) {
+        if (on_text) on_text(msg);
+        return true;
+    }
+    bool sendTXT(const String& msg) { return sendTXT(msg.c_str()); }
+    bool sendBIN(const uint8_t* data, size_t len) {
+        if (on_binary) on_binary(data, len);
+        return true;
+    }
+
+private:
+    WebSocketClientEvent event_ = nullptr;
+};
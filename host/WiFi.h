@@ -0,0 +1,19 @@
+#pragma once
+// Host stand-in for the ESP32 WiFi library: the host's network is always up.
+#include "Arduino.h"
+
+#define WL_CONNECTED 3
+
+class IPAddress {
+public:
+    String toString() const { return String("127.0.0.1"); }
+};
+
+class HostWiFi {
+public:
+    void begin(const char* ssid, const char* password) { (void)ssid; (void)password; }
+    int status() const { return WL_CONNECTED; }
+    IPAddress localIP() const { return IPAddress(); }
+};
+
+inline HostWiFi WiFi;
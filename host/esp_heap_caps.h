@@ -0,0 +1,20 @@
+#pragma once
+// Host stand-in for the ESP-IDF heap_caps API: every region maps to malloc.
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+static inline void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) { (void)caps; return calloc(n, size); }
+static inline void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps) { (void)caps; return realloc(ptr, size); }
+static inline void heap_caps_free(void* ptr) { free(ptr); }
+// The host heap has no meaningful per-region limits
+static inline size_t heap_caps_get_free_size(uint32_t caps) { (void)caps; return SIZE_MAX; }
+static inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { (void)caps; return SIZE_MAX; }
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps) { (void)caps; return SIZE_MAX; }
@@ -0,0 +1,244 @@
+// Per-layer benchmark of the sketch on the host (CMakeLists.txt in this
+// directory). Each layer is drawn on its own through sketch_draw_layer, over a
+// matrix of image sizes (r0, r4 and r5 draw from the image) and number/slider
+// values, with the layers' random streams reseeded for every case. Writes one JSON document:
+//
+//   {"benchmark":"sketch_layers","seed":1,"cores":2,"results":[
+//     {"layer":"r4","image":"64x64","number":10,"slider":0.5,"calls":..,"us_per_call":..,"min_us":..,
+//      "pixels_per_call":..,"mpixels_per_s":..,"allocs_per_call":..,"alloc_bytes_per_call":..}, ...]}
+//
+// pixels_per_call is the canvas area the layer marked dirty (for r0, the area
+// the image covers). Allocations count malloc/calloc/realloc and operator new
+// in the sketch's code during the timed calls; LVGL's own heap is not included.
+//
+//   sketch_bench [--seed N] [--min-ms N] [--quick] [--cores 1|2] [--layer rN] [--out file.json]
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include "sketch.h"
+#include "image_buffer.h"
+#include "render_jobs.h"
+#include "LVGL_Driver.h"
+
+char ip_address_str[16] = "127.0.0.1";
+float ws_slider_value = 0.5f;
+float ws_number_value = 1.0f;
+char ws_text_value[1024] = "default";
+int received_image_width = 0;
+int received_image_height = 0;
+
+// Allocation counting: the link step wraps malloc & co. (-Wl,--wrap), and
+// operator new/delete are replaced below
+static std::atomic<uint64_t> alloc_count{0};
+static std::atomic<uint64_t> alloc_bytes{0};
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return __real_malloc(size);
+}
+void* __wrap_calloc(size_t n, size_t size) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(n * size, std::memory_order_relaxed);
+    return __real_calloc(n, size);
+}
+void* __wrap_realloc(void* ptr, size_t size) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+void __wrap_free(void* ptr) {
+    __real_free(ptr);
+}
+}
+
+void* operator new(size_t size) {
+    void* p = __wrap_malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete(void* p) noexcept {
+    __wrap_free(p);
+}
+void operator delete[](void* p) noexcept {
+    __wrap_free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    __wrap_free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+    __wrap_free(p);
+}
+
+static const char* const layer_names[LAYER_COUNT] = { "r0", "r1", "r2", "r3", "r4", "r5" };
+
+struct BenchCase {
+    int layer;
+    int image; // side of the square image, 0 for layers that do not use it
+    float number;
+    float slider;
+};
+
+struct BenchResult {
+    int calls;
+    double total_us;
+    double min_us;
+    int64_t pixels;
+    uint64_t allocs;
+    uint64_t bytes;
+};
+
+static std::vector<uint16_t> source_pixels;
+
+// Gradient with a checkerboard, so the scaler and the dots see varied colours
+static void publish_image(int side) {
+    if ((int)source_pixels.size() != side * side) {
+        source_pixels.resize(side * side);
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                int r = x * 31 / (side > 1 ? side - 1 : 1);
+                int g = y * 63 / (side > 1 ? side - 1 : 1);
+                int b = ((x / 4) ^ (y / 4)) & 1 ? 31 : 4;
+                source_pixels[y * side + x] = (uint16_t)((r << 11) | (g << 5) | b);
+            }
+        }
+    }
+    ImageFrame* frame = image_buffer_begin_write(side, side);
+    if (!frame) return;
+    memcpy(frame->pixels, source_pixels.data(), source_pixels.size() * sizeof(uint16_t));
+    image_buffer_publish(frame);
+    received_image_width = side;
+    received_image_height = side;
+}
+
+static BenchResult run_case(const BenchCase& c, unsigned long seed, double min_ms) {
+    using clock = std::chrono::steady_clock;
+    ws_number_value = c.number;
+    ws_slider_value = c.slider;
+    publish_image(c.image ? c.image : 64);
+    sketch_seed(seed);
+    sketch_draw_layer(c.layer); // Warm-up: scaler tables, splat tables, caches
+
+    BenchResult r = { 0, 0, 1e30, 0, 0, 0 };
+    const int min_calls = 5, max_calls = 100000;
+    while (r.calls < min_calls || (r.total_us < min_ms * 1e3 && r.calls < max_calls)) {
+        if (c.layer == LAYER_R0) publish_image(c.image); // r0 draws only new images; not timed
+        uint64_t count = alloc_count.load(std::memory_order_relaxed);
+        uint64_t bytes = alloc_bytes.load(std::memory_order_relaxed);
+        auto start = clock::now();
+        int32_t pixels = sketch_draw_layer(c.layer);
+        double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+        r.allocs += alloc_count.load(std::memory_order_relaxed) - count;
+        r.bytes += alloc_bytes.load(std::memory_order_relaxed) - bytes;
+        r.pixels += pixels;
+        r.total_us += us;
+        if (us < r.min_us) r.min_us = us;
+        r.calls++;
+    }
+    return r;
+}
+
+static bool uses_image(int layer) {
+    return layer == LAYER_R0 || layer == LAYER_R4 || layer == LAYER_R5;
+}
+
+int main(int argc, char** argv) {
+    unsigned long seed = 1;
+    double min_ms = 200;
+    bool quick = false;
+    int cores = 2;
+    int only_layer = -1;
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (!strcmp(a, "--seed") && has_value) seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(a, "--min-ms") && has_value) min_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--cores") && has_value) cores = atoi(argv[++i]) == 1 ? 1 : 2;
+        else if (!strcmp(a, "--layer") && has_value) {
+            const char* name = argv[++i];
+            for (int l = 0; l < LAYER_COUNT; ++l) {
+                if (!strcmp(name, layer_names[l])) only_layer = l;
+            }
+        }
+        else if (!strcmp(a, "--out") && has_value) out_path = argv[++i];
+        else if (!strcmp(a, "--quick")) quick = true;
+        else {
+            fprintf(stderr, "usage: %s [--seed N] [--min-ms N] [--quick] [--cores 1|2] [--layer rN] [--out file.json]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "sketch_bench: could not write %s\n", out_path);
+        return 1;
+    }
+
+    Serial.enabled = false;
+    static uint16_t initial_pixels[16 * 16] = { 0 };
+    image_buffer_init(initial_pixels, 16, 16);
+    Lvgl_Init();
+    sketch_setup();
+    render_jobs_set_enabled(cores == 2);
+
+    const int all_images[] = { 16, 32, 64, 120, 240, 480 };
+    const int quick_images[] = { 16, 120, 480 };
+    const float all_numbers[] = { 1, 10, 100 };
+    const float quick_numbers[] = { 10 };
+    const float all_sliders[] = { 0.25f, 1.0f };
+    const float quick_sliders[] = { 0.5f };
+    std::vector<int> images(quick ? std::begin(quick_images) : std::begin(all_images),
+                            quick ? std::end(quick_images) : std::end(all_images));
+    std::vector<float> numbers(quick ? std::begin(quick_numbers) : std::begin(all_numbers),
+                               quick ? std::end(quick_numbers) : std::end(all_numbers));
+    std::vector<float> sliders(quick ? std::begin(quick_sliders) : std::begin(all_sliders),
+                               quick ? std::end(quick_sliders) : std::end(all_sliders));
+    if (quick) min_ms = min_ms < 50 ? min_ms : 50;
+
+    std::vector<BenchCase> cases;
+    for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+        if (only_layer >= 0 && layer != only_layer) continue;
+        std::vector<int> layer_images = uses_image(layer) ? images : std::vector<int>{ 0 };
+        // r0 does not use the number or slider
+        std::vector<float> layer_numbers = layer == LAYER_R0 ? std::vector<float>{ numbers[0] } : numbers;
+        std::vector<float> layer_sliders = layer == LAYER_R0 ? std::vector<float>{ sliders[0] } : sliders;
+        for (int image : layer_images)
+            for (float number : layer_numbers)
+                for (float slider : layer_sliders) cases.push_back({ layer, image, number, slider });
+    }
+
+    fprintf(out, "{\"benchmark\":\"sketch_layers\",\"seed\":%lu,\"cores\":%d,\"results\":[", seed, cores);
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const BenchCase& c = cases[i];
+        BenchResult r = run_case(c, seed, min_ms);
+        double us = r.total_us / r.calls;
+        char image[16] = "null";
+        if (c.image) snprintf(image, sizeof(image), "\"%dx%d\"", c.image, c.image);
+        fprintf(out,
+                "%s\n{\"layer\":\"%s\",\"image\":%s,\"number\":%g,\"slider\":%g,\"calls\":%d,\"us_per_call\":%.2f,"
+                "\"min_us\":%.2f,\"pixels_per_call\":%lld,\"mpixels_per_s\":%.2f,\"allocs_per_call\":%.2f,"
+                "\"alloc_bytes_per_call\":%.0f}",
+                i ? "," : "", layer_names[c.layer], image, c.number, c.slider, r.calls, us, r.min_us,
+                (long long)(r.pixels / r.calls), r.total_us > 0 ? r.pixels / r.total_us : 0.0,
+                (double)r.allocs / r.calls, (double)r.bytes / r.calls);
+        fflush(out);
+    }
+    fprintf(out, "\n]}\n");
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Headless host runner for the sketch: sets up LVGL with the in-memory display
+// (LVGL_Driver_host.cpp), publishes a test image, applies text commands the way
+// the network task would, and runs draw_frame plus the LVGL refresh as fast as
+// it can. Prints frames per second, and optionally writes the final screen as
+// a PPM. Build with CMakeLists.txt in this directory.
+//
+//   sketch_host [--frames N] [--image WxH] [--slider F] [--number F] [--seed N]
+//               [--quiet] [--dump out.ppm] [command ...]
+//
+// Each command ("r5 on", "r2 off", "fps 30", ...) is applied for one frame
+// before the timed frames, e.g.:
+//   ./sketch_host --frames 500 --image 120x120 --number 200 "r4 on" "r5 on" "fps 60"
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <chrono>
+#include <vector>
+#include "sketch.h"
+#include "image_buffer.h"
+#include "LVGL_Driver.h"
+
+// Globals the .ino defines on the device
+char ip_address_str[16] = "127.0.0.1";
+float ws_slider_value = 0.5f;
+float ws_number_value = 1.0f;
+char ws_text_value[1024] = "default";
+int received_image_width = 0;
+int received_image_height = 0;
+
+// Longer than any frame period ("fps 1"), so every step runs draw_frame once
+#define HOST_TICK_STEP_MS 1000
+
+static bool quiet = false;
+
+// Runs the LVGL timers once: draw_frame, then the display refresh
+static void step() {
+    lv_tick_inc(HOST_TICK_STEP_MS);
+    Lvgl_Loop();
+    char report[SKETCH_REPORT_MAX];
+    while (sketch_pop_report(report, sizeof(report))) {
+        if (!quiet) printf("%s\n", report);
+    }
+}
+
+// Smooth colour gradient with a few hard edges, as a stand-in for a camera image
+static void publish_test_image(int width, int height) {
+    ImageFrame* frame = image_buffer_begin_write(width, height);
+    if (!frame) {
+        fprintf(stderr, "sketch_host: no buffer for a %dx%d image\n", width, height);
+        return;
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int r = x * 31 / (width > 1 ? width - 1 : 1);
+            int g = y * 63 / (height > 1 ? height - 1 : 1);
+            int b = ((x / 8) ^ (y / 8)) & 1 ? 31 : 8;
+            frame->pixels[y * width + x] = (uint16_t)((r << 11) | (g << 5) | b);
+        }
+    }
+    image_buffer_publish(frame);
+    received_image_width = width;
+    received_image_height = height;
+}
+
+static bool write_ppm(const char* path, const lv_color_t* pixels, int width, int height) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    std::vector<uint8_t> row(width * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint16_t c = pixels[y * width + x].full;
+            row[x * 3 + 0] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+            row[x * 3 + 1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+            row[x * 3 + 2] = (uint8_t)((c & 0x1F) * 255 / 31);
+        }
+        fwrite(row.data(), 1, row.size(), f);
+    }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    int frames = 300;
+    int image_w = 64, image_h = 64;
+    unsigned long seed = 1;
+    const char* dump_path = nullptr;
+    std::vector<const char*> commands;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (!strcmp(a, "--frames") && has_value) frames = atoi(argv[++i]);
+        else if (!strcmp(a, "--image") && has_value) sscanf(argv[++i], "%dx%d", &image_w, &image_h);
+        else if (!strcmp(a, "--slider") && has_value) ws_slider_value = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--number") && has_value) ws_number_value = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--seed") && has_value) seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(a, "--dump") && has_value) dump_path = argv[++i];
+        else if (!strcmp(a, "--quiet")) quiet = true;
+        else if (a[0] == '-') {
+            fprintf(stderr, "usage: %s [--frames N] [--image WxH] [--slider F] [--number F] [--seed N] [--quiet] "
+                            "[--dump out.ppm] [command ...]\n", argv[0]);
+            return 2;
+        }
+        else commands.push_back(a);
+    }
+    Serial.enabled = !quiet;
+
+    static uint16_t initial_pixels[16 * 16] = { 0 };
+    image_buffer_init(initial_pixels, 16, 16);
+    Lvgl_Init();
+    sketch_setup();
+    sketch_seed(seed);
+    publish_test_image(image_w, image_h);
+
+    for (const char* command : commands) {
+        strlcpy(ws_text_value, command, sizeof(ws_text_value));
+        step();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t flushes = Lvgl_Host_Flush_Count();
+    for (int i = 0; i < frames; ++i) step();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    flushes = Lvgl_Host_Flush_Count() - flushes;
+
+    printf("%d frames in %.3f s: %.1f fps, %.3f ms/frame, %.1f flushed areas/frame\n", frames, seconds,
+           frames / seconds, seconds * 1e3 / (frames ? frames : 1), (double)flushes / (frames ? frames : 1));
+
+    if (dump_path && !write_ppm(dump_path, Lvgl_Host_Frame_Buffer(), LVGL_WIDTH, LVGL_HEIGHT)) {
+        fprintf(stderr, "sketch_host: could not write %s\n", dump_path);
+        return 1;
+    }
+    return 0;
+}
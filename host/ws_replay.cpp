@@ -0,0 +1,152 @@
+// Replays a recorded WebSocket session (ws_trace.h) through the sketch on the
+// host. The .ino is compiled in unchanged, so every event goes through the
+// same webSocketEvent(), JSON, base64, JPEG and tile code as on the device.
+// The replay plays both sides of the device: the network task's periodic
+// work (frame acks, sketch reports) and loop(), stepped every
+// LVGL_TICK_PERIOD ms of trace time. Build with CMakeLists.txt in this
+// directory.
+//
+//   ws_replay [--realtime] [--seed N] [--budget MS] [--tail MS] [--hashes out.txt]
+//             [--quiet] session.wstr
+//
+// The sketch runs on simulated time (millis, the LVGL tick), so a run does not
+// depend on the host's speed: the same trace and seed draw the same frames,
+// which --hashes lists one per refreshed frame so two runs can be diffed.
+// --realtime only paces the replay to the recorded timestamps. Stage timings
+// ({"type":"stats"} messages) are measured and differ from run to run; so
+// would the frame scheduler's cuts, so the layer budget is set to --budget
+// (default 100000 ms, i.e. unlimited) before the first event. --budget 0
+// leaves the scheduler as the trace sets it, at the cost of repeatability.
+
+#include "lvgl_sketch_web.ino"
+#include "ws_trace.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define REPLAY_WARMUP_MS 1000 // Longer than any frame period ("fps 1")
+
+static bool quiet = false;
+static FILE* hashes_file = nullptr;
+static uint32_t frames = 0;
+static uint64_t run_hash = 14695981039346656037ull; // FNV-1a over all frame hashes
+static uint32_t last_flush_count = 0;
+static uint32_t texts_sent = 0;
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static void print_sent_text(const char* msg) {
+    texts_sent++;
+    if (!quiet) printf("-> %s\n", msg);
+}
+
+static bool read_file(const char* path, std::vector<uint8_t>* out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) out->insert(out->end(), chunk, chunk + n);
+    fclose(f);
+    return true;
+}
+
+// One pass of each side, then LVGL_TICK_PERIOD ms of simulated time (loop()'s delay)
+static void step(bool realtime, std::chrono::steady_clock::time_point wall_start, unsigned long trace_start) {
+    send_frame_ack();
+    send_sketch_reports();
+    loop();
+    lv_tick_inc(LVGL_TICK_PERIOD);
+
+    uint32_t flushes = Lvgl_Host_Flush_Count();
+    if (flushes != last_flush_count) {
+        last_flush_count = flushes;
+        uint64_t h = fnv1a(14695981039346656037ull, Lvgl_Host_Frame_Buffer(),
+                           (size_t)LVGL_WIDTH * LVGL_HEIGHT * sizeof(lv_color_t));
+        run_hash = fnv1a(run_hash, &h, sizeof(h));
+        if (hashes_file) fprintf(hashes_file, "%u %lu %016llx\n", (unsigned)frames, millis(), (unsigned long long)h);
+        frames++;
+    }
+    if (realtime) std::this_thread::sleep_until(wall_start + std::chrono::milliseconds(millis() - trace_start));
+}
+
+int main(int argc, char** argv) {
+    const char* trace_path = nullptr;
+    const char* hashes_path = nullptr;
+    bool realtime = false;
+    bool usage = false;
+    unsigned long seed = 1;
+    long budget_ms = 100000;
+    unsigned long tail_ms = 1000;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (!strcmp(a, "--realtime")) realtime = true;
+        else if (!strcmp(a, "--seed") && has_value) seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(a, "--budget") && has_value) budget_ms = atol(argv[++i]);
+        else if (!strcmp(a, "--tail") && has_value) tail_ms = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(a, "--hashes") && has_value) hashes_path = argv[++i];
+        else if (!strcmp(a, "--quiet")) quiet = true;
+        else if (a[0] != '-' && !trace_path) trace_path = a;
+        else usage = true;
+    }
+    if (!trace_path || usage) {
+        fprintf(stderr, "usage: ws_replay [--realtime] [--seed N] [--budget MS] [--tail MS] [--hashes out.txt] "
+                        "[--quiet] session.wstr\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> trace;
+    WsTraceReader reader;
+    if (!read_file(trace_path, &trace) || !ws_trace_reader_init(&reader, trace.data(), trace.size())) {
+        fprintf(stderr, "ws_replay: %s is not a readable trace\n", trace_path);
+        return 1;
+    }
+    if (hashes_path && !(hashes_file = fopen(hashes_path, "w"))) {
+        fprintf(stderr, "ws_replay: cannot write %s\n", hashes_path);
+        return 1;
+    }
+
+    Serial.enabled = !quiet;
+    webSocket.on_text = print_sent_text;
+    host_clock_simulate();
+    setup(); // No board, WiFi or network task on the host; see the stand-ins in this directory
+    sketch_seed(seed);
+    auto wall_start = std::chrono::steady_clock::now();
+    unsigned long trace_start = millis();
+    if (budget_ms > 0) {
+        // draw_frame reads commands once per frame period; give it one before the first event
+        snprintf(ws_text_value, sizeof(ws_text_value), "budget %ld", budget_ms);
+        while (millis() - trace_start < REPLAY_WARMUP_MS) step(false, wall_start, trace_start);
+        trace_start = millis();
+        wall_start = std::chrono::steady_clock::now();
+    }
+    uint32_t events = 0;
+    uint32_t last_event_ms = 0;
+    std::vector<uint8_t> payload;
+    WsTraceEvent ev;
+    while (ws_trace_next(&reader, &ev)) {
+        while (millis() - trace_start < ev.time_ms) step(realtime, wall_start, trace_start);
+        // The library hands the handler a writable, null-terminated copy
+        payload.assign(ev.payload, ev.payload + ev.len);
+        payload.push_back(0);
+        webSocketEvent((WStype_t)ev.type, payload.data(), ev.len);
+        events++;
+        last_event_ms = ev.time_ms;
+    }
+    if (reader.pos != reader.end) fprintf(stderr, "ws_replay: trace truncated after %u events\n", (unsigned)events);
+    while (millis() - trace_start < (unsigned long)last_event_ms + tail_ms) step(realtime, wall_start, trace_start);
+
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    printf("replay: %u events over %u ms of trace in %.0f ms, %u frames, %u messages sent, run hash %016llx\n",
+           (unsigned)events, (unsigned)last_event_ms, wall_ms, (unsigned)frames, (unsigned)texts_sent,
+           (unsigned long long)run_hash);
+    if (hashes_file) fclose(hashes_file);
+    return 0;
+}
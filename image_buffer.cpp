@@ -0,0 +1,145 @@
+#include "image_buffer.h"
+#include <atomic>
+#include <string.h>
+#include "psram_pool.h"
+
+static ImageFrame slots[2];
+static std::atomic<int> front_index{0};
+static std::atomic<int> readers[2];
+static uint32_t publish_count = 0;
+
+// Presentation counters, written by one side each and read from anywhere
+static std::atomic<uint32_t> presented_frame_id{0};
+static std::atomic<uint32_t> presented_count{0};
+static std::atomic<uint32_t> skipped_count{0};  // reader side
+static std::atomic<uint32_t> dropped_count{0};  // writer side
+static uint32_t presented_seq = 0;               // reader only
+
+// All atomics use the default sequentially consistent ordering: the reader's
+// "increment readers, then re-check front" and the writer's "publish, then
+// check readers" must not be reordered against each other.
+
+void image_buffer_init(uint16_t* pixels, int width, int height) {
+    ImageFrame& f = slots[0];
+    f.pixels = pixels;
+    f.width = width;
+    f.height = height;
+    f.capacity = (size_t)width * height * sizeof(uint16_t);
+    f.owned = false;
+    f.seq = ++publish_count;
+    f.frame_id = 0;
+    f.dirty_all = true;
+    f.dirty_count = 0;
+    front_index.store(0);
+}
+
+// Returns the back slot if the reader is not using it
+static ImageFrame* claim_back() {
+    int back = 1 - front_index.load();
+    // The reader may still be drawing from the previous front buffer
+    if (readers[back].load() != 0) return nullptr;
+    return &slots[back];
+}
+
+static bool reserve(ImageFrame& f, int width, int height) {
+    size_t needed = (size_t)width * height * sizeof(uint16_t);
+    if (!f.owned || f.capacity < needed) {
+        // Return the old block first so the pool can hand it to the next size change
+        if (f.owned) psram_pool_free(f.pixels);
+        f.pixels = (uint16_t*)psram_pool_alloc(needed, HEAP_TAG_IMAGE);
+        f.owned = f.pixels != nullptr;
+        f.capacity = psram_pool_block_size(f.pixels);
+        if (!f.pixels) return false;
+    }
+    f.width = width;
+    f.height = height;
+    f.seq = 0; // Contents no longer match any published frame
+    f.frame_id = 0;
+    f.dirty_count = 0;
+    return true;
+}
+
+ImageFrame* image_buffer_begin_write(int width, int height) {
+    if (width <= 0 || height <= 0) return nullptr;
+
+    ImageFrame* f = claim_back();
+    if (!f || !reserve(*f, width, height)) return nullptr;
+    f->dirty_all = true;
+    return f;
+}
+
+static void copy_rect(ImageFrame& dst, const ImageFrame& src, const ImageRect& r) {
+    for (int y = r.y; y < r.y + r.h; ++y) {
+        size_t offset = (size_t)y * src.width + r.x;
+        memcpy(dst.pixels + offset, src.pixels + offset, r.w * sizeof(uint16_t));
+    }
+}
+
+ImageFrame* image_buffer_begin_update(int width, int height) {
+    ImageFrame* f = claim_back();
+    if (!f) return nullptr;
+    // The front buffer is never written while published, so it can be read here
+    const ImageFrame& front = slots[front_index.load()];
+    if (!front.pixels || front.width != width || front.height != height) return nullptr;
+
+    // The back buffer still holds the frame published just before the front
+    // one: bring it up to date by copying only what changed in between
+    bool previous = f->owned && f->seq != 0 && f->seq + 1 == front.seq && f->width == width && f->height == height;
+    if (!reserve(*f, width, height)) return nullptr;
+    if (previous && !front.dirty_all) {
+        for (int i = 0; i < front.dirty_count; ++i) copy_rect(*f, front, front.dirty[i]);
+    } else {
+        memcpy(f->pixels, front.pixels, (size_t)width * height * sizeof(uint16_t));
+    }
+    f->dirty_all = false;
+    return f;
+}
+
+void image_buffer_mark_dirty(ImageFrame* frame, int x, int y, int w, int h) {
+    if (frame->dirty_all) return;
+    if (frame->dirty_count == IMAGE_MAX_DIRTY_RECTS) {
+        frame->dirty_all = true;
+        return;
+    }
+    frame->dirty[frame->dirty_count++] = { (uint16_t)x, (uint16_t)y, (uint16_t)w, (uint16_t)h };
+}
+
+void image_buffer_publish(ImageFrame* frame) {
+    frame->seq = ++publish_count;
+    front_index.store((int)(frame - slots));
+}
+
+void image_buffer_note_dropped() {
+    dropped_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void image_buffer_mark_presented(const ImageFrame* frame) {
+    if (frame->seq == presented_seq) return;
+    // Publish sequence numbers are consecutive, so a gap means frames nobody saw
+    if (presented_seq != 0 && frame->seq > presented_seq + 1) {
+        skipped_count.fetch_add(frame->seq - presented_seq - 1, std::memory_order_relaxed);
+    }
+    presented_seq = frame->seq;
+    presented_count.fetch_add(1, std::memory_order_relaxed);
+    presented_frame_id.store(frame->frame_id, std::memory_order_release);
+}
+
+void image_buffer_get_present_stats(ImagePresentStats* stats) {
+    stats->frame_id = presented_frame_id.load(std::memory_order_acquire);
+    stats->presented = presented_count.load(std::memory_order_relaxed);
+    stats->dropped = skipped_count.load(std::memory_order_relaxed) + dropped_count.load(std::memory_order_relaxed);
+}
+
+const ImageFrame* image_buffer_acquire() {
+    for (;;) {
+        int idx = front_index.load();
+        readers[idx].fetch_add(1);
+        // Re-check: if a publish happened in between, the writer may already own this slot
+        if (front_index.load() == idx) return &slots[idx];
+        readers[idx].fetch_sub(1);
+    }
+}
+
+void image_buffer_release(const ImageFrame* frame) {
+    readers[frame - slots].fetch_sub(1);
+}
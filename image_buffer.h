@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Front/back pair of decoded image buffers shared between the network task
+// (single writer) and the render loop (single reader).
+//
+// The writer decodes into the back buffer and publishes it with a single
+// atomic store, so the reader always sees pixels, width and height that
+// belong together. The reader pins the front buffer while drawing; a pinned
+// buffer is never written, and the writer drops a frame rather than wait.
+// Buffers come from psram_pool, are reused across frames and are only
+// exchanged when an image no longer fits its buffer's size class.
+//
+// Delta updates (image_buffer_begin_update) start from a copy of the front
+// image and record the rectangles they change, so the reader can redraw just
+// those regions when it has seen the previous frame.
+
+#define IMAGE_MAX_DIRTY_RECTS 64 // More changed regions than this count as a full update
+
+struct ImageRect {
+    uint16_t x, y, w, h;
+};
+
+struct ImageFrame {
+    uint16_t* pixels; // RGB565, width * height
+    int width;
+    int height;
+    size_t capacity;  // bytes available in pixels
+    bool owned;       // pixels was allocated here (false for the static test image)
+    uint32_t seq;     // publish counter, changes every time a new image is published
+    uint32_t frame_id; // sender's sequence number (ws_frame.h), 0 if it had none
+    // Regions that differ from the frame published just before (seq - 1)
+    bool dirty_all;   // the whole image may differ; dirty[] is then unused
+    uint16_t dirty_count;
+    ImageRect dirty[IMAGE_MAX_DIRTY_RECTS];
+};
+
+// Publishes a static initial image (not owned, never freed). Call before the writer starts.
+void image_buffer_init(uint16_t* pixels, int width, int height);
+
+// Writer: returns the back buffer, sized for width x height, or nullptr if the
+// reader is still using it or the allocation failed. The contents are undefined.
+ImageFrame* image_buffer_begin_write(int width, int height);
+
+// Writer: returns the back buffer holding a copy of the current front image, to
+// be patched in place and published with its changes marked via
+// image_buffer_mark_dirty. Only the regions changed since the back buffer was
+// last published are copied when possible. Returns nullptr if the reader is
+// still using the back buffer, the allocation failed, or the front image is
+// not width x height.
+ImageFrame* image_buffer_begin_update(int width, int height);
+
+// Writer: records a changed region of a frame from image_buffer_begin_update.
+void image_buffer_mark_dirty(ImageFrame* frame, int x, int y, int w, int h);
+
+// Writer: makes the frame returned by image_buffer_begin_write/begin_update the front buffer.
+// A frame that is not published is simply reused by the next begin_write.
+void image_buffer_publish(ImageFrame* frame);
+
+// Writer: counts a received frame that was not published (busy, decode error, ...).
+void image_buffer_note_dropped();
+
+// Reader: records that frame made it to the screen. Published frames that were
+// replaced before the reader saw them count as dropped.
+void image_buffer_mark_presented(const ImageFrame* frame);
+
+struct ImagePresentStats {
+    uint32_t frame_id;  // frame_id of the frame presented last
+    uint32_t presented; // frames presented
+    uint32_t dropped;   // frames dropped by the writer or replaced before being presented
+};
+
+// Any task.
+void image_buffer_get_present_stats(ImagePresentStats* stats);
+
+// Reader: pins and returns the current front buffer (never nullptr after init).
+const ImageFrame* image_buffer_acquire();
+
+// Reader: unpins a frame returned by image_buffer_acquire.
+void image_buffer_release(const ImageFrame* frame);
@@ -0,0 +1,171 @@
+#include "image_scaler.h"
+#include <string.h>
+
+#define RGB565_SPREAD_MASK 0x07E0F81Fu // G in bits 21-26, R in 11-15, B in 0-4
+
+// Spreads the channels of an RGB565 pixel apart so two pixels can be weighted
+// with one multiplication each (5-bit weights leave room for the products)
+static inline uint32_t spread(uint16_t p) {
+    return (p | ((uint32_t)p << 16)) & RGB565_SPREAD_MASK;
+}
+
+static inline uint16_t unspread(uint32_t v) {
+    return (uint16_t)(v | (v >> 16));
+}
+
+// a * (32 - w) + b * w, w in 0..32
+static inline uint32_t lerp_spread(uint32_t a, uint32_t b, uint32_t w) {
+    return ((a * (32 - w) + b * w) >> 5) & RGB565_SPREAD_MASK;
+}
+
+// Bilinear sample position for destination index i: source index and 5-bit
+// weight of the next source index, sampling at pixel centres
+static void bilinear_pos(int i, int src, int dst, int* index, uint8_t* weight) {
+    int64_t f = (((int64_t)(2 * i + 1) * src) << 16) / (2 * dst) - 32768;
+    if (f < 0) f = 0;
+    int idx = (int)(f >> 16);
+    int w = (int)((f & 0xFFFF) >> 11);
+    if (idx >= src - 1) { // Right/bottom edge: full weight on the last pixel
+        idx = src - 2;
+        w = 32;
+    }
+    *index = idx;
+    *weight = (uint8_t)w;
+}
+
+bool image_scaler_setup(ImageScaler* s, int src_w, int src_h, int dst_w, int dst_h, ImageScaleMode mode) {
+    if (src_w <= 0 || src_h <= 0 || src_w > 0xFFFF || dst_w <= 0 || dst_h <= 0 || dst_w > IMAGE_SCALER_MAX_WIDTH) {
+        return false;
+    }
+    // A single row or column has nothing to interpolate between
+    if (mode == IMAGE_SCALE_BILINEAR && (src_w < 2 || src_h < 2)) mode = IMAGE_SCALE_NEAREST;
+    // Without downscaling every box is a single pixel
+    if (mode == IMAGE_SCALE_AREA && src_w <= dst_w && src_h <= dst_h) mode = IMAGE_SCALE_NEAREST;
+    if (s->src_w == src_w && s->src_h == src_h && s->dst_w == dst_w && s->dst_h == dst_h && s->mode == mode) {
+        return true;
+    }
+
+    s->src_w = src_w;
+    s->src_h = src_h;
+    s->dst_w = dst_w;
+    s->dst_h = dst_h;
+    s->mode = mode;
+    s->identity_x = mode == IMAGE_SCALE_NEAREST && src_w == dst_w;
+
+    for (int x = 0; x < dst_w; ++x) {
+        if (mode == IMAGE_SCALE_BILINEAR) {
+            int idx;
+            bilinear_pos(x, src_w, dst_w, &idx, &s->col_span[x]);
+            s->col[x] = (uint16_t)idx;
+        } else {
+            int start = (int)((int64_t)x * src_w / dst_w);
+            int end = (int)(((int64_t)(x + 1) * src_w + dst_w - 1) / dst_w);
+            int span = end - start;
+            if (span < 1) span = 1;
+            if (span > IMAGE_SCALER_MAX_BOX) span = IMAGE_SCALER_MAX_BOX;
+            s->col[x] = (uint16_t)start;
+            s->col_span[x] = (uint8_t)span;
+        }
+    }
+    if (mode == IMAGE_SCALE_AREA) {
+        // Rounded up so a box of identical pixels averages back to the same value
+        for (int n = 1; n <= IMAGE_SCALER_MAX_BOX * IMAGE_SCALER_MAX_BOX; ++n) {
+            s->inv_count[n] = (65536 + n - 1) / n;
+        }
+    }
+    return true;
+}
+
+static void run_nearest_row(const ImageScaler* s, const uint16_t* srow, uint16_t* d, int x0, int x1) {
+    if (s->identity_x) {
+        memcpy(d + x0, srow + x0, (x1 - x0) * sizeof(uint16_t));
+        return;
+    }
+    const uint16_t* col = s->col;
+    int x = x0;
+    for (; x + 4 <= x1; x += 4) {
+        d[x] = srow[col[x]];
+        d[x + 1] = srow[col[x + 1]];
+        d[x + 2] = srow[col[x + 2]];
+        d[x + 3] = srow[col[x + 3]];
+    }
+    for (; x < x1; ++x) d[x] = srow[col[x]];
+}
+
+static void run_bilinear_row(const ImageScaler* s, const uint16_t* r0, const uint16_t* r1, uint32_t wy,
+                             uint16_t* d, int x0, int x1) {
+    for (int x = x0; x < x1; ++x) {
+        int c = s->col[x];
+        uint32_t wx = s->col_span[x];
+        uint32_t top = lerp_spread(spread(r0[c]), spread(r0[c + 1]), wx);
+        uint32_t bottom = lerp_spread(spread(r1[c]), spread(r1[c + 1]), wx);
+        d[x] = unspread(lerp_spread(top, bottom, wy));
+    }
+}
+
+static void run_area_row(const ImageScaler* s, const uint16_t* src, int sy, int rows, uint16_t* d, int x0, int x1) {
+    for (int x = x0; x < x1; ++x) {
+        int c = s->col[x];
+        int span = s->col_span[x];
+        uint32_t r = 0, g = 0, b = 0;
+        for (int yy = 0; yy < rows; ++yy) {
+            const uint16_t* p = src + (size_t)(sy + yy) * s->src_w + c;
+            for (int xx = 0; xx < span; ++xx) {
+                uint16_t v = p[xx];
+                r += v >> 11;
+                g += (v >> 5) & 0x3F;
+                b += v & 0x1F;
+            }
+        }
+        uint32_t inv = s->inv_count[rows * span];
+        d[x] = (uint16_t)((((r * inv) >> 16) << 11) | (((g * inv) >> 16) << 5) | ((b * inv) >> 16));
+    }
+}
+
+void image_scaler_run(const ImageScaler* s, const uint16_t* src, uint16_t* dst, int dst_stride,
+                      int x0, int y0, int x1, int y1) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > s->dst_w) x1 = s->dst_w;
+    if (y1 > s->dst_h) y1 = s->dst_h;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    const uint16_t* prev_row = nullptr; // last destination row produced, for vertical repeats
+    int prev_key = -1;
+
+    for (int y = y0; y < y1; ++y) {
+        uint16_t* d = dst + (size_t)y * dst_stride;
+        int sy, key, rows = 1;
+        uint8_t wy = 0;
+        if (s->mode == IMAGE_SCALE_BILINEAR) {
+            bilinear_pos(y, s->src_h, s->dst_h, &sy, &wy);
+            key = (sy << 6) | wy;
+        } else {
+            sy = (int)((int64_t)y * s->src_h / s->dst_h);
+            if (s->mode == IMAGE_SCALE_AREA) {
+                int end = (int)(((int64_t)(y + 1) * s->src_h + s->dst_h - 1) / s->dst_h);
+                rows = end - sy;
+                if (rows < 1) rows = 1;
+                if (rows > IMAGE_SCALER_MAX_BOX) rows = IMAGE_SCALER_MAX_BOX;
+            }
+            key = (sy << 6) | rows;
+        }
+
+        // Upscaling repeats source rows: copy the destination row just produced
+        if (key == prev_key) {
+            memcpy(d + x0, prev_row + x0, (x1 - x0) * sizeof(uint16_t));
+            continue;
+        }
+
+        const uint16_t* srow = src + (size_t)sy * s->src_w;
+        if (s->mode == IMAGE_SCALE_BILINEAR) {
+            run_bilinear_row(s, srow, srow + s->src_w, wy, d, x0, x1);
+        } else if (s->mode == IMAGE_SCALE_AREA) {
+            run_area_row(s, src, sy, rows, d, x0, x1);
+        } else {
+            run_nearest_row(s, srow, d, x0, x1);
+        }
+        prev_row = d;
+        prev_key = key;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// RGB565 image scaler with per-size lookup tables.
+//
+// image_scaler_setup() precomputes, once per (source size, destination size,
+// mode), which source column(s) feed every destination column (positions in
+// 16.16 fixed point). image_scaler_run() then only does table lookups and
+// integer math: destination rows that map to the same source row as the
+// previous one are copied with memcpy, and a 1:1 column map copies whole
+// source rows.
+
+#define IMAGE_SCALER_MAX_WIDTH 1024 // Largest destination width
+#define IMAGE_SCALER_MAX_BOX 16     // Area mode averages at most this many samples per axis
+
+enum ImageScaleMode : uint8_t {
+    IMAGE_SCALE_NEAREST = 0,
+    IMAGE_SCALE_BILINEAR,  // 2x2 taps, 5-bit weights
+    IMAGE_SCALE_AREA,      // box average of the covered source pixels (for downscaling)
+};
+
+struct ImageScaler {
+    int src_w, src_h;
+    int dst_w, dst_h;
+    ImageScaleMode mode;
+    bool identity_x;                               // destination column x reads source column x
+    uint16_t col[IMAGE_SCALER_MAX_WIDTH];          // first source column per destination column
+    uint8_t col_span[IMAGE_SCALER_MAX_WIDTH];      // area: source columns averaged; bilinear: weight of col + 1 (0..32)
+    uint32_t inv_count[IMAGE_SCALER_MAX_BOX * IMAGE_SCALER_MAX_BOX + 1]; // area: 65536 / n
+};
+
+// Prepares s for scaling src_w x src_h to dst_w x dst_h. Cheap if nothing
+// changed since the last call. Returns false if a size is out of range.
+bool image_scaler_setup(ImageScaler* s, int src_w, int src_h, int dst_w, int dst_h, ImageScaleMode mode);
+
+// Scales the destination region [x0, x1) x [y0, y1) (clipped to dst_w x dst_h).
+// dst points at destination pixel (0, 0); dst_stride is in pixels.
+void image_scaler_run(const ImageScaler* s, const uint16_t* src, uint16_t* dst, int dst_stride,
+                      int x0, int y0, int x1, int y1);
@@ -0,0 +1,56 @@
+#include "layer_rng.h"
+
+// splitmix32: spreads a seed over the state words, so nearby seeds give
+// unrelated sequences
+static uint32_t splitmix32(uint32_t* x) {
+    uint32_t z = (*x += 0x9e3779b9u);
+    z = (z ^ (z >> 16)) * 0x85ebca6bu;
+    z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+    return z ^ (z >> 16);
+}
+
+void rng_seed(Rng* r, uint32_t seed, uint32_t stream) {
+    uint32_t x = seed;
+    for (int i = 0; i < 4; ++i) r->s[i] = splitmix32(&x);
+    if ((r->s[0] | r->s[1] | r->s[2] | r->s[3]) == 0) r->s[0] = 1; // The all-zero state never leaves zero
+    for (uint32_t i = 0; i < stream; ++i) rng_jump(r);
+}
+
+void rng_jump(Rng* r) {
+    static const uint32_t jump[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 32; ++b) {
+            if (jump[i] & (1u << b)) {
+                s0 ^= r->s[0];
+                s1 ^= r->s[1];
+                s2 ^= r->s[2];
+                s3 ^= r->s[3];
+            }
+            rng_next(r);
+        }
+    }
+    r->s[0] = s0;
+    r->s[1] = s1;
+    r->s[2] = s2;
+    r->s[3] = s3;
+}
+
+void rng_fill_below(Rng* r, uint16_t* out, size_t count, uint32_t n) {
+    uint32_t s0 = r->s[0], s1 = r->s[1], s2 = r->s[2], s3 = r->s[3];
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t result = rng_rotl(s1 * 5, 7) * 9;
+        uint32_t t = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rng_rotl(s3, 11);
+        out[i] = (uint16_t)(((uint64_t)result * n) >> 32);
+    }
+    r->s[0] = s0;
+    r->s[1] = s1;
+    r->s[2] = s2;
+    r->s[3] = s3;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Small, seedable random number generator for the drawing layers:
+// xoshiro128** (Blackman and Vigna), 16 bytes of state and only 32-bit
+// shifts, rotates and adds per number, which suits the ESP32-S3 better than
+// a generator built on 64-bit multiplies.
+//
+// Each layer draws from its own stream: rng_seed(seed, stream) derives the
+// state from the seed and then jumps 2^64 numbers ahead per stream number, so
+// streams never overlap and a layer's sequence does not depend on how much
+// the other layers drew. The same seed gives the same pictures on the
+// device and on the host.
+//
+// rng_below() maps a number to [0, n) with a multiply and a shift instead of
+// a division. That is biased by less than n / 2^32, which is invisible at
+// canvas sizes.
+
+struct Rng {
+    uint32_t s[4];
+};
+
+// Seeds stream number `stream` of `seed`
+void rng_seed(Rng* r, uint32_t seed, uint32_t stream);
+
+// Advances the generator by 2^64 numbers (the start of the next stream)
+void rng_jump(Rng* r);
+
+static inline uint32_t rng_rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+static inline uint32_t rng_next(Rng* r) {
+    uint32_t* s = r->s;
+    uint32_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 11);
+    return result;
+}
+
+// Uniform in [0, n)
+static inline uint32_t rng_below(Rng* r, uint32_t n) {
+    return (uint32_t)(((uint64_t)rng_next(r) * n) >> 32);
+}
+
+// Uniform in [lo, hi), like Arduino's random(lo, hi); lo if hi <= lo
+static inline int32_t rng_between(Rng* r, int32_t lo, int32_t hi) {
+    return hi > lo ? lo + (int32_t)rng_below(r, (uint32_t)(hi - lo)) : lo;
+}
+
+// Uniform in [0, 1) as 16.16 fixed point, i.e. [0, 65536)
+static inline uint32_t rng_unit_q16(Rng* r) {
+    return rng_next(r) >> 16;
+}
+
+// Uniform in [0, 1); 24 bits, no division
+static inline float rng_unit(Rng* r) {
+    return (float)(rng_next(r) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Fills out[0, count) with numbers uniform in [0, n), n <= 65536: the same
+// numbers as count rng_below() calls, with the state kept in registers
+void rng_fill_below(Rng* r, uint16_t* out, size_t count, uint32_t n);
@@ -2,21 +2,63 @@
 
 #include <WiFi.h>
 #include <WebSocketsClient.h> // Include the WebSocket library
+#if defined(ESP_PLATFORM) // host/ws_replay.cpp builds this file without the board drivers
 #include "TCA9554PWR.h"
 #include "Display_ST7701.h"
+#include <SPIFFS.h>
+#endif
 #include "LVGL_Driver.h"
 #include "sketch.h"
 #include <ArduinoJson.h> // Include ArduinoJson library
 #include "base64_utils.h"
 #include <JPEGDEC.h> // Include JPEG decoder library
+#include "ws_frame.h"
+#include "ws_control.h"
+#include "ws_reassembly.h"
+#include "spsc_queue.h"
+#include "image_buffer.h"
+#include "psram_pool.h"
+#include "heap_stats.h"
+#include "stage_timer.h"
+#include "ws_trace.h"
 
 // --- WebSocket and JPEG Decoding Globals ---
 static JPEGDEC jpeg; // JPEG decoder instance
 static uint16_t* g_jpeg_target_buffer = nullptr; // Target buffer for JPEG callback
 static int g_jpeg_target_width = 0; // Target width for JPEG callback
-static bool decoded_buffer_is_dynamic = false; // Tracks if decoded_img_buffer is on heap
+static int g_jpeg_target_height = 0; // Target height for JPEG callback
+static int image_decode_scale = 1; // Scale the current image was decoded at (1, 2, 4 or 8)
+static uint32_t image_frame_seq = 0; // Sequence number of the current binary image frame
+static bool image_frame_seq_valid = false; // Tile frames can be applied on top of the current image
+static bool keyframe_requested = false; // A full frame was requested and has not arrived yet
+static uint32_t keyframe_request_ms = 0; // When it was requested
+#define KEYFRAME_RETRY_MS 1000 // Ask again if the keyframe does not arrive in time
+#define TILE_WAIT_TICKS 20 // How long a tile frame waits for the render loop to release the back buffer
+static uint32_t ack_dropped_frame_id = 0; // Last binary frame dropped by the network task
+static bool ack_dropped_pending = false; // ... and not acknowledged yet
+#define WS_FRAGMENT_ARENA_SIZE (1024 * 1024) // Largest fragmented message accepted, in bytes
+static WsReassembly ws_fragments; // Reassembles fragmented messages into a fixed PSRAM arena
 // --- End WebSocket and JPEG Globals ---
 
+// --- Session Trace ---
+// "trace start" records every event webSocketEvent() receives into a PSRAM
+// buffer (ws_trace.h), "trace stop" ends the recording and saves it to flash,
+// "trace send" sends the last recording to the server as a binary message.
+// host/ws_replay.cpp plays a trace back through this file on a PC.
+// A recording is limited to the free SPIFFS space, and it is saved a chunk per
+// pass of the network task, so the WebSocket keeps being serviced meanwhile.
+#define TRACE_CAPACITY (2 * 1024 * 1024) // Bytes of events one recording can hold at most
+#define TRACE_FILE "/session.wstr"
+#define TRACE_SAVE_CHUNK 4096            // Bytes written to SPIFFS per network task pass
+#define TRACE_SPIFFS_RESERVE 8192        // Free space left for SPIFFS' own bookkeeping
+static WsTraceWriter session_trace; // Buffer allocated by the first "trace start"
+static bool trace_saving = false;   // Being written to TRACE_FILE; the buffer must not change
+static size_t trace_saved = 0;      // Bytes written so far
+#if defined(ESP_PLATFORM)
+static File trace_file;
+#endif
+// --- End Session Trace ---
+
 // --- Connection Settings ---
 const char *WIFI_SSID = "YOUR WIFI SSID"; // <-- IMPORTANT: Replace with your Wi-Fi SSID
 const char *WIFI_PASSWORD = "YOUR WIFI PASSWORD";              // <-- IMPORTANT: Replace with your Wi-Fi Password
@@ -25,6 +67,7 @@ const char* WEBSOCKET_SERVER_IP = "YOUR WEBSOCKET SERVER"; // <-- IMPORTANT: Rep
 const uint16_t WEBSOCKET_SERVER_PORT = 5001;       // <-- IMPORTANT: Replace with your server's port number if different
 WebSocketsClient webSocket;
 bool isWebSocketConnected = false; // Track connection status
+static bool websocket_started = false; // webSocket.begin() was called
 // --- End WebSocket Settings ---
 
 
@@ -36,41 +79,310 @@ int received_image_width = 0;         // To store width from WebSocket message
 int received_image_height = 0;        // To store height from WebSocket message
 
 // --- Image Buffer Globals ---
+// Decoded images are double-buffered in image_buffer.cpp; this is the initial image
 uint16_t test_pixel_buffer[16 * 16];
-uint16_t *decoded_img_buffer = test_pixel_buffer; 
-size_t decoded_img_size = sizeof(test_pixel_buffer);
-// int decoded_img_width = 16; // MOVED TO SKETCH.CPP
-// int decoded_img_height = 16; // MOVED TO SKETCH.CPP
-volatile bool new_image_available = true; 
 // --- End Global Control Variables ---
 
+// --- Network Task Handoff ---
+// WebSocket servicing and image decoding run in network_task on NET_TASK_CORE.
+// Control updates reach the render loop (loop() on the other core) through a
+// lock-free single-producer/single-consumer queue, drained by
+// drain_network_events(); decoded images are published through image_buffer.h.
+#define NET_TASK_CORE 0
+#define NET_TASK_STACK_SIZE (8 * 1024)
+#define NET_TASK_PRIORITY 2
+
+// A parsed slider/number/text update
+struct ControlUpdate {
+    WsControlMsg msg;
+    char text[sizeof(ws_text_value)];
+};
+
+static SpscQueue<ControlUpdate, 8> control_queue;   // network task -> render loop
+static TaskHandle_t net_task_handle = nullptr;
+// --- End Network Task Handoff ---
+
+// --- JSON Parsing Globals ---
+// Allocates ArduinoJson pools in PSRAM
+struct SpiRamAllocator {
+    void *allocate(size_t size) { return heap_tag_malloc(HEAP_TAG_JSON, size, MALLOC_CAP_SPIRAM); }
+    void deallocate(void *pointer) { heap_tag_free(pointer); }
+    void *reallocate(void *ptr, size_t new_size) { return heap_tag_realloc(HEAP_TAG_JSON, ptr, new_size, MALLOC_CAP_SPIRAM); }
+};
+using SpiRamJsonDocument = BasicJsonDocument<SpiRamAllocator>;
+
+#define JSON_ARENA_CAPACITY (16 * 1024) // Value tree only; strings stay in the payload (zero-copy)
+
+static SpiRamJsonDocument *json_arena = nullptr; // Reused for every non-control message
+static char ws_control_text[sizeof(ws_text_value)]; // Scratch for unescaped text values
+// --- End JSON Parsing Globals ---
+
 // JPEG Draw Callback function
 // This function is called by the JPEGDEC library to draw pixels.
-// We use it to copy pixel data into our global decoded_img_buffer.
+// We use it to copy pixel data into the buffer being decoded (g_jpeg_target_buffer).
+// The block is clipped to the target once, then copied row by row.
 int jpegDrawCallback(JPEGDRAW *pDraw) {
     if (!g_jpeg_target_buffer || g_jpeg_target_width == 0) {
         Serial.println("[jpegDrawCallback] Error: Target buffer or width not set!");
         return 0; // Stop decoding if setup is incorrect
     }
 
-    uint16_t *src_pixels = pDraw->pPixels; // Pixels from the current MCU
+    // Blocks on the right/bottom edge may extend past the image (MCU padding)
+    int copy_w = min(pDraw->iWidth, g_jpeg_target_width - pDraw->x);
+    int copy_h = min(pDraw->iHeight, g_jpeg_target_height - pDraw->y);
+    if (copy_w <= 0 || copy_h <= 0) return 1;
+
+    const uint16_t *src = pDraw->pPixels; // Pixels from the current MCU, iWidth per row
+    uint16_t *dst = g_jpeg_target_buffer + pDraw->y * g_jpeg_target_width + pDraw->x;
+    for (int y = 0; y < copy_h; y++) {
+        memcpy(dst, src, copy_w * sizeof(uint16_t));
+        src += pDraw->iWidth;
+        dst += g_jpeg_target_width;
+    }
+    return 1; // Return 1 to continue decoding
+}
 
-    for (int y = 0; y < pDraw->iHeight; y++) {
-        for (int x = 0; x < pDraw->iWidth; x++) {
-            int dest_x = pDraw->x + x;
-            int dest_y = pDraw->y + y;
+// Picks the largest JPEGDEC scale (1, 2, 4 or 8) that still leaves the image at
+// least as large as the layers need (sketch_get_image_target)
+static int choose_jpeg_scale(int width, int height)
+{
+    int target_w, target_h;
+    sketch_get_image_target(&target_w, &target_h);
+    int scale = 8;
+    while (scale > 1 && (width / scale < target_w || height / scale < target_h)) {
+        scale /= 2;
+    }
+    return scale;
+}
 
-            // Ensure we are within the bounds of our target buffer
-            // decoded_img_height is a global variable updated before decode starts
-            if (dest_x < g_jpeg_target_width && dest_y < decoded_img_height) {
-                g_jpeg_target_buffer[dest_y * g_jpeg_target_width + dest_x] = src_pixels[y * pDraw->iWidth + x];
-            } else {
-                // This might happen if JPEG dimensions are slightly off or MCU overlaps boundary
-                // Serial.printf("[jpegDrawCallback] Warning: Pixel out of bounds (%d, %d)\n", dest_x, dest_y);
+// Returns the back image buffer to decode into, or nullptr if the frame has to be dropped
+static ImageFrame* begin_image_write(int width, int height)
+{
+    ImageFrame* frame = image_buffer_begin_write(width, height);
+    if (!frame) {
+        Serial.printf("[IMG] Back buffer busy or out of memory, %dx%d frame dropped\n", width, height);
+    }
+    return frame;
+}
+
+// Decodes a JPEG held in memory into the back image buffer and publishes it.
+// Shared by the JSON/base64 path and the binary frame path. On failure the
+// current image stays on screen.
+static bool decode_jpeg_image(const uint8_t* jpg, size_t jpg_len, uint32_t frame_id)
+{
+    StageScope scope(STAGE_JPEG);
+    if (!jpeg.openRAM((uint8_t*)jpg, jpg_len, jpegDrawCallback)) {
+        // Serial.println("[JPEG] jpeg.openRAM() failed!");
+        return false;
+    }
+    jpeg.setPixelType(RGB565_LITTLE_ENDIAN); // Critical for LVGL compatibility
+
+    // Decode at reduced size when the layers cannot use the full resolution
+    int scale = choose_jpeg_scale(jpeg.getWidth(), jpeg.getHeight());
+    int options = scale == 8 ? JPEG_SCALE_EIGHTH : scale == 4 ? JPEG_SCALE_QUARTER : scale == 2 ? JPEG_SCALE_HALF : 0;
+    int new_img_width = jpeg.getWidth() / scale;
+    int new_img_height = jpeg.getHeight() / scale;
+    bool ok = false;
+
+    ImageFrame* back = (new_img_width > 0 && new_img_height > 0) ? begin_image_write(new_img_width, new_img_height) : nullptr;
+    if (back) {
+        g_jpeg_target_buffer = back->pixels;
+        g_jpeg_target_width = new_img_width;
+        g_jpeg_target_height = new_img_height;
+
+        if (jpeg.decode(0, 0, options)) {
+            back->frame_id = frame_id;
+            image_buffer_publish(back);
+            image_decode_scale = scale;
+            ok = true;
+        } else {
+            // Serial.println("[JPEG] Decode FAILED!");
+            // The back buffer is not published and gets reused by the next image
+        }
+        // Clear global helpers
+        g_jpeg_target_buffer = nullptr;
+        g_jpeg_target_width = 0;
+        g_jpeg_target_height = 0;
+    }
+    jpeg.close();
+    return ok;
+}
+
+// Copies a raw RGB565 image (little-endian) into the back image buffer and publishes it
+static bool load_rgb565_image(const uint8_t* data, size_t len, int width, int height, uint32_t frame_id)
+{
+    if (width <= 0 || height <= 0 || len < (size_t)width * height * sizeof(uint16_t)) {
+        return false;
+    }
+    ImageFrame* back = begin_image_write(width, height);
+    if (!back) return false;
+    memcpy(back->pixels, data, (size_t)width * height * sizeof(uint16_t));
+    back->frame_id = frame_id;
+    image_buffer_publish(back);
+    image_decode_scale = 1;
+    return true;
+}
+
+// Network task side: a binary frame will never be presented. It still counts as
+// handled for flow control, so the sender does not wait for it.
+static void note_frame_dropped(uint32_t frame_id)
+{
+    image_buffer_note_dropped();
+    ack_dropped_frame_id = frame_id;
+    ack_dropped_pending = true;
+}
+
+// Network task side: tells the sender which frame the device finished last
+// (presented by the render loop, or dropped), plus the running counters.
+// The sender keeps at most a few frames in flight (see README, flow control).
+static void send_frame_ack()
+{
+    static uint32_t acked_presented = 0;
+    ImagePresentStats stats;
+    image_buffer_get_present_stats(&stats);
+    if (stats.presented == acked_presented && !ack_dropped_pending) return;
+    if (!isWebSocketConnected) return;
+
+    // Whichever happened last: the render loop showing a frame or the network task dropping one
+    uint32_t seq = stats.presented != acked_presented ? stats.frame_id : ack_dropped_frame_id;
+    if (ack_dropped_pending && stats.presented != acked_presented && (int32_t)(ack_dropped_frame_id - seq) > 0) {
+        seq = ack_dropped_frame_id;
+    }
+    acked_presented = stats.presented;
+    ack_dropped_pending = false;
+    if (seq == 0) return; // Image without a sequence number (JSON or the initial test image)
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "{\"type\":\"ack\",\"seq\":%u,\"presented\":%u,\"dropped\":%u}", (unsigned)seq,
+             (unsigned)stats.presented, (unsigned)stats.dropped);
+    webSocket.sendTXT(msg);
+}
+
+// Sends the sketch's reports (e.g. {"type":"sched"}), dropping them while no client is connected
+static void send_sketch_reports()
+{
+    static char msg[SKETCH_REPORT_MAX];
+    while (sketch_pop_report(msg, sizeof(msg))) {
+        if (isWebSocketConnected) webSocket.sendTXT(msg);
+    }
+}
+
+// Asks the sender for a full image frame, once until one arrives (or the request times out)
+static void request_keyframe()
+{
+    if (keyframe_requested && millis() - keyframe_request_ms < KEYFRAME_RETRY_MS) return;
+    keyframe_requested = true;
+    keyframe_request_ms = millis();
+    webSocket.sendTXT("{\"type\":\"keyframe\"}");
+}
+
+// Copies one RGB565 tile into the image, subsampling it when the image was
+// decoded at a reduced scale
+static void blit_tile(ImageFrame* frame, const WsFrameTile& tile, int scale)
+{
+    int x0 = (tile.x + scale - 1) / scale;
+    int y0 = (tile.y + scale - 1) / scale;
+    int x1 = min((tile.x + tile.w + scale - 1) / scale, frame->width);
+    int y1 = min((tile.y + tile.h + scale - 1) / scale, frame->height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* src = tile.pixels + ((size_t)(y * scale - tile.y) * tile.w + (x0 * scale - tile.x)) * 2;
+        uint16_t* dst = frame->pixels + (size_t)y * frame->width + x0;
+        if (scale == 1) {
+            memcpy(dst, src, (x1 - x0) * sizeof(uint16_t));
+        } else {
+            for (int x = x0; x < x1; x++, src += scale * 2) {
+                *dst++ = (uint16_t)(src[0] | (src[1] << 8));
             }
         }
     }
-    return 1; // Return 1 to continue decoding
+    image_buffer_mark_dirty(frame, x0, y0, x1 - x0, y1 - y0);
+}
+
+// Patches the current image with the tiles of a WS_FRAME_TYPE_TILES frame.
+// Tiles only make sense on top of the frame they were diffed against, so a
+// gap in the sequence numbers (a dropped frame) triggers a keyframe request.
+static bool apply_image_tiles(const WsFrameHeader& hdr, const uint8_t* payload)
+{
+    if (hdr.codec != WS_FRAME_CODEC_RGB565 || !image_frame_seq_valid || hdr.seq != image_frame_seq + 1) {
+        image_frame_seq_valid = false;
+        request_keyframe();
+        return false;
+    }
+
+    int scale = image_decode_scale;
+    WsTileReader reader;
+    // Dropping a tile frame costs a keyframe, so wait a little for the back buffer
+    ImageFrame* back = image_buffer_begin_update(hdr.width / scale, hdr.height / scale);
+    for (int i = 0; !back && i < TILE_WAIT_TICKS; i++) {
+        vTaskDelay(1);
+        back = image_buffer_begin_update(hdr.width / scale, hdr.height / scale);
+    }
+    if (!back || !ws_frame_tiles_begin(payload, hdr.payload_len, &reader)) {
+        image_frame_seq_valid = false;
+        request_keyframe();
+        return false;
+    }
+
+    WsFrameTile tile;
+    while (ws_frame_next_tile(&reader, hdr.width, hdr.height, &tile)) {
+        blit_tile(back, tile, scale);
+    }
+    if (reader.remaining != 0) {
+        // Truncated or out-of-bounds tile: the patched image is incomplete
+        Serial.printf("[WSc] Tile frame %u is malformed\n", (unsigned)hdr.seq);
+        image_frame_seq_valid = false;
+        request_keyframe();
+        return false;
+    }
+    back->frame_id = hdr.seq;
+    image_buffer_publish(back);
+    image_frame_seq = hdr.seq;
+    return true;
+}
+
+// Handles a binary frame (see ws_frame.h); the payload goes straight to the decoder
+static void handle_binary_frame(const uint8_t* data, size_t length)
+{
+    WsFrameHeader hdr;
+    const uint8_t* frame_payload = nullptr;
+    if (!ws_frame_parse(data, length, &hdr, &frame_payload)) {
+        Serial.printf("[WSc] Invalid binary frame (%u bytes)\n", (unsigned)length);
+        return;
+    }
+    if (hdr.type == WS_FRAME_TYPE_TILES) {
+        if (!apply_image_tiles(hdr, frame_payload)) {
+            Serial.printf("[WSc] Tile frame %u dropped, keyframe requested\n", (unsigned)hdr.seq);
+            note_frame_dropped(hdr.seq);
+        }
+        return;
+    }
+    if (hdr.type != WS_FRAME_TYPE_IMAGE) {
+        Serial.printf("[WSc] Unsupported binary frame type: %u\n", hdr.type);
+        return;
+    }
+
+    received_image_width = hdr.width;
+    received_image_height = hdr.height;
+
+    bool ok = false;
+    if (hdr.codec == WS_FRAME_CODEC_JPEG) {
+        ok = decode_jpeg_image(frame_payload, hdr.payload_len, hdr.seq);
+    } else if (hdr.codec == WS_FRAME_CODEC_RGB565) {
+        ok = load_rgb565_image(frame_payload, hdr.payload_len, hdr.width, hdr.height, hdr.seq);
+    } else {
+        Serial.printf("[WSc] Unsupported image codec: %u\n", hdr.codec);
+        return;
+    }
+    // Later tile frames build on this one
+    image_frame_seq = hdr.seq;
+    image_frame_seq_valid = ok;
+    if (ok) keyframe_requested = false;
+    if (!ok) {
+        Serial.printf("[WSc] Binary image frame %u failed to decode\n", (unsigned)hdr.seq);
+        note_frame_dropped(hdr.seq);
+    }
 }
 
 // Helper to initialize the test pixel buffer with random colors
@@ -79,13 +391,8 @@ void init_test_pixel_buffer() {
     for (int i = 0; i < 16 * 16; ++i) {
         test_pixel_buffer[i] = random(0, 0xFFFF);
     }
-    decoded_img_buffer = test_pixel_buffer; 
-    // decoded_img_width = 16; // Will use the one from sketch.cpp, initialized there
-    // decoded_img_height = 16; // Will use the one from sketch.cpp, initialized there
-    // Ensure sketch.cpp initializes these to 16 for the test buffer initially
-    decoded_img_size = sizeof(test_pixel_buffer); 
-    new_image_available = true;
-    Serial.println("[InitTestPixelBuffer] Test pixel buffer initialized and new_image_available set to true.");
+    image_buffer_init(test_pixel_buffer, 16, 16); // Published as the initial front buffer
+    Serial.println("[InitTestPixelBuffer] Test pixel buffer initialized and published.");
 }
 
 // --- Temporary Text Label ---
@@ -114,197 +421,344 @@ static void text_label_delete_timer_cb(lv_timer_t *timer)
 
 char ip_address_str[16] = "Connecting...";
 
-// --- WebSocket Event Handler ---
-void webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
+// --- JSON Parsing ---
+static SpiRamJsonDocument *get_json_arena()
 {
-    switch (type)
+    if (!json_arena)
     {
-    case WStype_DISCONNECTED:
-        Serial.printf("[WSc] Disconnected!\n");
-        isWebSocketConnected = false;
+        json_arena = new SpiRamJsonDocument(JSON_ARENA_CAPACITY);
+        if (json_arena->capacity() == 0)
+        {
+            delete json_arena;
+            json_arena = nullptr;
+        }
+    }
+    return json_arena;
+}
+
+// Network task side: queues a control update for the render loop
+static void post_control(WsControlType type, float value, const char *text)
+{
+    static ControlUpdate update; // Too large for the network task's stack
+    update.msg.type = type;
+    update.msg.value = value;
+    update.msg.text_len = 0;
+    if (text) {
+        strncpy(update.text, text, sizeof(update.text) - 1);
+        update.text[sizeof(update.text) - 1] = '\0';
+        update.msg.text_len = strlen(update.text);
+    }
+    if (!control_queue.push(update)) {
+        Serial.println("[WSc] Control queue full, update dropped");
+    }
+}
+
+// Render loop side: applies a queued control update
+static void apply_control_message(const ControlUpdate &update)
+{
+    switch (update.msg.type)
+    {
+    case WS_CONTROL_SLIDER:
+        ws_slider_value = update.msg.value;
         break;
-    case WStype_CONNECTED:
-        Serial.printf("[WSc] Connected to url: %s\n", payload);
-        isWebSocketConnected = true;
+    case WS_CONTROL_NUMBER:
+        ws_number_value = update.msg.value;
         break;
-    case WStype_TEXT:
-    { 
-        DynamicJsonDocument doc(6 * 1024 * 1024); // Increased capacity for potentially large base64
-        DeserializationError error = deserializeJson(doc, payload, length);
+    case WS_CONTROL_TEXT:
+        memcpy(ws_text_value, update.text, update.msg.text_len + 1); // Includes the terminator
+        break;
+    default:
+        break;
+    }
+}
+// --- End JSON Parsing ---
 
-        if (error)
-        {
-            Serial.print(F("[WSc] deserializeJson() failed: "));
-            Serial.println(error.f_str());
-            return;
+
+// --- Session Trace Commands ---
+// Bytes a recording may take: TRACE_CAPACITY, or less if that would not fit in
+// SPIFFS once the previous recording is deleted. 0 if SPIFFS is unusable.
+static size_t trace_capacity()
+{
+#if defined(ESP_PLATFORM)
+    if (!SPIFFS.begin(true)) {
+        Serial.println("[Trace] SPIFFS mount failed");
+        return 0;
+    }
+    SPIFFS.remove(TRACE_FILE);
+    size_t free_bytes = SPIFFS.totalBytes() - SPIFFS.usedBytes();
+    free_bytes = free_bytes > TRACE_SPIFFS_RESERVE ? free_bytes - TRACE_SPIFFS_RESERVE : 0;
+    return free_bytes < TRACE_CAPACITY ? free_bytes : TRACE_CAPACITY;
+#else
+    return TRACE_CAPACITY; // Nothing is saved on the host
+#endif
+}
+
+// Starts saving the stopped recording to TRACE_FILE; save_trace_step() writes it
+static void save_trace_begin()
+{
+#if defined(ESP_PLATFORM)
+    if (trace_saving) return;
+    trace_file = SPIFFS.open(TRACE_FILE, FILE_WRITE);
+    if (!trace_file) {
+        Serial.println("[Trace] Cannot create " TRACE_FILE);
+        return;
+    }
+    trace_saved = 0;
+    trace_saving = true;
+#endif
+}
+
+// Network task: writes the next TRACE_SAVE_CHUNK bytes of the recording being saved
+static void save_trace_step()
+{
+#if defined(ESP_PLATFORM)
+    if (!trace_saving) return;
+    size_t chunk = session_trace.len - trace_saved;
+    if (chunk > TRACE_SAVE_CHUNK) chunk = TRACE_SAVE_CHUNK;
+    size_t written = trace_file.write(session_trace.buf + trace_saved, chunk);
+    trace_saved += written;
+    if (written == chunk && trace_saved < session_trace.len) return;
+    trace_file.close();
+    trace_saving = false;
+    Serial.printf("[Trace] %u of %u bytes saved to %s\n", (unsigned)trace_saved, (unsigned)session_trace.len, TRACE_FILE);
+#endif
+}
+
+// Network task side: handles "trace start|stop|send". Returns false for any other text.
+static bool handle_trace_command(const char *text)
+{
+    if (strncmp(text, "trace ", 6) != 0) return false;
+    const char *cmd = text + 6;
+    if (strcmp(cmd, "start") == 0) {
+        if (trace_saving) {
+            Serial.println("[Trace] Still saving the previous recording");
+            return true;
+        }
+        uint8_t *buf = session_trace.buf;
+        if (!buf) buf = (uint8_t *)heap_tag_malloc(HEAP_TAG_NET, TRACE_CAPACITY, MALLOC_CAP_SPIRAM);
+        ws_trace_init(&session_trace, buf, trace_capacity());
+        if (ws_trace_start(&session_trace, millis())) {
+            Serial.printf("[Trace] Recording (up to %u bytes)\n", (unsigned)session_trace.capacity);
+        } else {
+            Serial.println(buf ? "[Trace] No SPIFFS space for a recording" : "[Trace] No memory for the trace buffer");
+        }
+    } else if (strcmp(cmd, "stop") == 0) {
+        if (!session_trace.recording && !session_trace.overflowed) return true; // Nothing recorded (or a replay)
+        ws_trace_stop(&session_trace);
+        Serial.printf("[Trace] Stopped: %u events, %u bytes\n", (unsigned)session_trace.records, (unsigned)session_trace.len);
+        save_trace_begin();
+    } else if (strcmp(cmd, "send") == 0) {
+        if (session_trace.recording || session_trace.len == 0) {
+            Serial.println("[Trace] Nothing to send (stop the recording first)");
+        } else if (isWebSocketConnected) {
+            webSocket.sendBIN(session_trace.buf, session_trace.len);
         }
+    } else {
+        return false;
+    }
+    return true;
+}
+// --- End Session Trace Commands ---
 
-        const char *msg_type = doc["type"];
+// Network task side: answers "heap" right away, so it can be polled (the sketch
+// only sees a text command when it changes)
+static bool handle_heap_command(const char *text)
+{
+    if (strcmp(text, "heap") != 0) return false;
+    static char msg[HEAP_STATS_REPORT_MAX];
+    if (!heap_stats_format(msg, sizeof(msg))) {
+        Serial.println("[Heap] Report does not fit HEAP_STATS_REPORT_MAX");
+        return true;
+    }
+    Serial.println(msg);
+    if (isWebSocketConnected) webSocket.sendTXT(msg);
+    return true;
+}
+
+// Text commands the network task handles itself instead of passing them to the sketch
+static bool handle_network_command(const char *text)
+{
+    return handle_trace_command(text) || handle_heap_command(text);
+}
 
-        if (msg_type)
+// Handles a complete text message (JSON)
+static void handle_text_message(uint8_t *payload, size_t length)
+{
+    // Fast path: slider/number/text messages are parsed without touching the heap
+    WsControlMsg ctrl;
+    bool is_control;
+    {
+        StageScope scope(STAGE_JSON);
+        is_control = ws_control_parse((const char *)payload, length, &ctrl, ws_control_text, sizeof(ws_control_text));
+    }
+    if (is_control)
+    {
+        if (ctrl.type == WS_CONTROL_TEXT && handle_network_command(ws_control_text)) return;
+        post_control(ctrl.type, ctrl.value, ctrl.type == WS_CONTROL_TEXT ? ws_control_text : nullptr);
+        return;
+    }
+
+    // Everything else (images) goes through ArduinoJson. The payload is parsed in place
+    // (zero-copy), so the reusable document only holds the value tree, not the base64 string.
+    SpiRamJsonDocument *doc_ptr = get_json_arena();
+    if (!doc_ptr)
+    {
+        Serial.println(F("[WSc] JSON arena unavailable"));
+        return;
+    }
+    SpiRamJsonDocument &doc = *doc_ptr;
+    DeserializationError error;
+    {
+        StageScope scope(STAGE_JSON);
+        error = deserializeJson(doc, (char *)payload, length);
+    }
+
+    if (error)
+    {
+        Serial.print(F("[WSc] deserializeJson() failed: "));
+        Serial.println(error.c_str());
+        return;
+    }
+
+    const char *msg_type = doc["type"];
+
+    if (msg_type)
+    {
+        if (strcmp(msg_type, "slider") == 0)
         {
-            if (strcmp(msg_type, "slider") == 0)
-            {
-                ws_slider_value = doc["value"].as<float>();
-                // Serial.printf("[WSc] Slider value: %f\n", ws_slider_value);
-            }
-            else if (strcmp(msg_type, "number") == 0)
-            {
-                ws_number_value = doc["value"].as<float>();
-                // Serial.printf("[WSc] Number value: %f\n", ws_number_value);
-            }
-            else if (strcmp(msg_type, "text") == 0)
-            {
-                const char *txt = doc["value"];
-                if (txt) {
-                    strncpy(ws_text_value, txt, sizeof(ws_text_value) - 1);
-                    ws_text_value[sizeof(ws_text_value) - 1] = '\0'; // Ensure null termination
-                    // Serial.printf("[WSc] Text value: %s\n", ws_text_value);
-                    // display_temporary_text(ws_text_value); // Assuming this function exists and is defined elsewhere
-                }
+            post_control(WS_CONTROL_SLIDER, doc["value"].as<float>(), nullptr);
+        }
+        else if (strcmp(msg_type, "number") == 0)
+        {
+            post_control(WS_CONTROL_NUMBER, doc["value"].as<float>(), nullptr);
+        }
+        else if (strcmp(msg_type, "text") == 0)
+        {
+            const char *txt = doc["value"];
+            if (txt && !handle_network_command(txt)) {
+                post_control(WS_CONTROL_TEXT, 0.0f, txt);
+                // display_temporary_text(ws_text_value); // Assuming this function exists and is defined elsewhere
             }
-            else if (strcmp(msg_type, "image") == 0)
-            {
-                // Serial.println("[WSc] 'image' message type identified."); // Confirm this block is reached
-                // Print the raw payload for debugging
-                // Serial.printf("[WSc] Raw payload for 'image' (length %zu): %.*s\n", length, (int)length, (char*)payload);
-
-                if (doc.containsKey("data")) { // MODIFIED: Check for "data" key
-                    JsonVariant image_val = doc["data"]; // MODIFIED: Get "data" key
-                    if (image_val.isNull()) {
-                        // Serial.println("[WSc] JSON 'data' field is null."); // MODIFIED: Log for "data"
-                    } else if (image_val.is<const char*>()) {
-                        const char* b64_data = image_val.as<const char*>();
-                        // Serial.printf("[WSc] JSON 'data' field (string) starts with: %.*s...\n", 30, b64_data ? b64_data : "NULL_PTR"); // MODIFIED: Log for "data"
-                        if (b64_data) {
-                            // Serial.printf("[WSc] JSON 'data' field string length: %d\n", strlen(b64_data)); // MODIFIED: Log for "data"
-                        }
-                    } else {
-                        // Serial.printf("[WSc] JSON 'data' field is not a string. Actual type: %s\n", image_val.is<int>() ? "int" : image_val.is<float>() ? "float" : image_val.is<bool>() ? "bool" : image_val.is<JsonArray>() ? "array" : image_val.is<JsonObject>() ? "object" : "unknown"); // MODIFIED: Log for "data"
+        }
+        else if (strcmp(msg_type, "image") == 0)
+        {
+            // Serial.println("[WSc] 'image' message type identified."); // Confirm this block is reached
+            // Print the raw payload for debugging
+            // Serial.printf("[WSc] Raw payload for 'image' (length %zu): %.*s\n", length, (int)length, (char*)payload);
+
+            if (doc.containsKey("data")) { // MODIFIED: Check for "data" key
+                JsonVariant image_val = doc["data"]; // MODIFIED: Get "data" key
+                if (image_val.isNull()) {
+                    // Serial.println("[WSc] JSON 'data' field is null."); // MODIFIED: Log for "data"
+                } else if (image_val.is<const char*>()) {
+                    const char* b64_data = image_val.as<const char*>();
+                    // Serial.printf("[WSc] JSON 'data' field (string) starts with: %.*s...\n", 30, b64_data ? b64_data : "NULL_PTR"); // MODIFIED: Log for "data"
+                    if (b64_data) {
+                        // Serial.printf("[WSc] JSON 'data' field string length: %d\n", strlen(b64_data)); // MODIFIED: Log for "data"
                     }
                 } else {
-                    // Serial.println("[WSc] JSON 'data' field is missing for 'image' type."); // MODIFIED: Log for "data"
+                    // Serial.printf("[WSc] JSON 'data' field is not a string. Actual type: %s\n", image_val.is<int>() ? "int" : image_val.is<float>() ? "float" : image_val.is<bool>() ? "bool" : image_val.is<JsonArray>() ? "array" : image_val.is<JsonObject>() ? "object" : "unknown"); // MODIFIED: Log for "data"
                 }
+            } else {
+                // Serial.println("[WSc] JSON 'data' field is missing for 'image' type."); // MODIFIED: Log for "data"
+            }
 
-                // Extract width and height if present
-                if (doc.containsKey("width") && doc["width"].is<int>()) {
-                    received_image_width = doc["width"].as<int>();
-                } else {
-                    received_image_width = 0; // Default or indicate error
-                }
-                if (doc.containsKey("height") && doc["height"].is<int>()) {
-                    received_image_height = doc["height"].as<int>();
-                } else {
-                    received_image_height = 0; // Default or indicate error
+            // Extract width and height if present
+            if (doc.containsKey("width") && doc["width"].is<int>()) {
+                received_image_width = doc["width"].as<int>();
+            } else {
+                received_image_width = 0; // Default or indicate error
+            }
+            if (doc.containsKey("height") && doc["height"].is<int>()) {
+                received_image_height = doc["height"].as<int>();
+            } else {
+                received_image_height = 0; // Default or indicate error
+            }
+            // Optional: Log received dimensions
+            // Serial.printf("[WSc] Received image dimensions: %d x %d\n", received_image_width, received_image_height);
+
+
+            const char *base64_image_data = doc["data"]; 
+            if (base64_image_data) {
+                // Serial.println("[WSc] Received image data (base64_image_data is not null). Decoding...");
+                size_t b64_decoded_len;
+                uint8_t *jpeg_raw_data;
+                {
+                    StageScope scope(STAGE_BASE64);
+                    jpeg_raw_data = base64_decode_to_psram(base64_image_data, &b64_decoded_len);
                 }
-                // Optional: Log received dimensions
-                // Serial.printf("[WSc] Received image dimensions: %d x %d\n", received_image_width, received_image_height);
-
-
-                const char *base64_image_data = doc["data"]; 
-                if (base64_image_data) {
-                    // Serial.println("[WSc] Received image data (base64_image_data is not null). Decoding...");
-                    size_t b64_decoded_len;
-                    uint8_t *jpeg_raw_data = base64_decode_to_psram(base64_image_data, &b64_decoded_len);
-
-                    if (jpeg_raw_data && b64_decoded_len > 0) {
-                        // Serial.printf("[JPEG] Base64 decoded to %d bytes in PSRAM.\n", b64_decoded_len);
-
-                        if (jpeg.openRAM(jpeg_raw_data, b64_decoded_len, jpegDrawCallback)) {
-                            // Serial.println("[JPEG] RAM buffer opened.");
-                            jpeg.setPixelType(RGB565_LITTLE_ENDIAN); // Critical for LVGL compatibility
-
-                            int new_img_width = jpeg.getWidth();
-                            int new_img_height = jpeg.getHeight();
-                            // Serial.printf("[JPEG] Dimensions: %d x %d\n", new_img_width, new_img_height);
-
-                            if (new_img_width > 0 && new_img_height > 0) {
-                                size_t new_buffer_byte_size = (size_t)new_img_width * new_img_height * sizeof(uint16_t);
-                                uint16_t* temp_new_pixel_buffer = (uint16_t*)heap_caps_malloc(new_buffer_byte_size, MALLOC_CAP_SPIRAM);
-
-                                if (temp_new_pixel_buffer) {
-                                    // Serial.printf("[JPEG] Allocated %zu bytes for new pixel buffer in PSRAM.\n", new_buffer_byte_size);
-
-                                    if (decoded_buffer_is_dynamic && decoded_img_buffer != nullptr && decoded_img_buffer != test_pixel_buffer) {
-                                        // Serial.println("[JPEG] Freeing previous dynamic image buffer.");
-                                        heap_caps_free(decoded_img_buffer);
-                                    }
-
-                                    decoded_img_buffer = temp_new_pixel_buffer;
-                                    decoded_img_width = new_img_width;
-                                    decoded_img_height = new_img_height; // Set before decode for callback
-                                    decoded_img_size = new_buffer_byte_size;
-                                    decoded_buffer_is_dynamic = true;
-
-                                    g_jpeg_target_buffer = decoded_img_buffer;
-                                    g_jpeg_target_width = decoded_img_width;
-
-                                    // Serial.println("[JPEG] Starting decode process...");
-                                    if (jpeg.decode(0, 0, 0)) {
-                                        // Serial.println("[JPEG] Decode successful.");
-                                        new_image_available = true;
-                                    } else {
-                                        // Serial.println("[JPEG] Decode FAILED!");
-                                        heap_caps_free(decoded_img_buffer); // Free the just-allocated buffer
-                                        // Revert to test buffer
-                                        decoded_img_buffer = test_pixel_buffer;
-                                        decoded_img_width = 16;
-                                        decoded_img_height = 16;
-                                        decoded_img_size = sizeof(test_pixel_buffer);
-                                        decoded_buffer_is_dynamic = false;
-                                        new_image_available = true; // Show test image
-                                    }
-                                } else {
-                                    // Serial.println("[JPEG] Failed to allocate PSRAM for new pixel buffer!");
-                                }
-                            } else {
-                                // Serial.println("[JPEG] Header invalid or image dimensions are zero.");
-                            }
-                            jpeg.close();
-                            // Serial.println("[JPEG] Closed.");
-                        } else {
-                            // Serial.println("[JPEG] jpeg.openRAM() failed!");
-                        }
-                        heap_caps_free(jpeg_raw_data); // Free the base64 decoded data
-                        // Serial.println("[JPEG] Freed base64 decoded data buffer.");
-                    } else {
-                        // Serial.println("[JPEG] Base64 decoding failed or produced zero length data.");
-                        if (jpeg_raw_data) heap_caps_free(jpeg_raw_data); // Safety free
-                    }
-                    // Clear global helpers
-                    g_jpeg_target_buffer = nullptr;
-                    g_jpeg_target_width = 0;
+
+                if (jpeg_raw_data && b64_decoded_len > 0) {
+                    // Serial.printf("[JPEG] Base64 decoded to %d bytes in PSRAM.\n", b64_decoded_len);
+                    decode_jpeg_image(jpeg_raw_data, b64_decoded_len, 0);
+                    image_frame_seq_valid = false; // Tile frames only follow binary frames
+                    psram_pool_free(jpeg_raw_data); // Return the base64 scratch to the pool
+                    // Serial.println("[JPEG] Freed base64 decoded data buffer.");
                 } else {
-                    // Serial.println("[WSc] Debug: base64_image_data (from doc's 'data' field) is null."); // MODIFIED: Log for "data"
+                    // Serial.println("[JPEG] Base64 decoding failed or produced zero length data.");
+                    if (jpeg_raw_data) psram_pool_free(jpeg_raw_data); // Safety free
                 }
+            } else {
+                // Serial.println("[WSc] Debug: base64_image_data (from doc's 'data' field) is null."); // MODIFIED: Log for "data"
             }
-            // ... any other message types ...
         }
-        else
-        {
-            Serial.println("[WSc] Received JSON without 'type' field.");
-        }
-    } 
-    break;
+        // ... any other message types ...
+    }
+    else
+    {
+        Serial.println("[WSc] Received JSON without 'type' field.");
+    }
+}
+
+// --- WebSocket Event Handler ---
+void webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
+{
+    // Recorded before handling: the JSON path parses the payload in place
+    if (session_trace.recording && !ws_trace_record(&session_trace, millis(), type, payload, length)) {
+        Serial.printf("[Trace] Buffer full after %u events, recording stopped\n", (unsigned)session_trace.records);
+    }
+
+    switch (type)
+    {
+    case WStype_DISCONNECTED:
+        Serial.printf("[WSc] Disconnected!\n");
+        isWebSocketConnected = false;
+        break;
+    case WStype_CONNECTED:
+        Serial.printf("[WSc] Connected to url: %s\n", payload);
+        isWebSocketConnected = true;
+        image_frame_seq_valid = false; // The sender starts over with a full frame
+        keyframe_requested = false;
+        break;
+    case WStype_TEXT:
+        handle_text_message(payload, length);
+        break;
     case WStype_BIN:
-        Serial.printf("[WSc] Received binary data of length: %u\n", length);
+        handle_binary_frame(payload, length);
         break;
     case WStype_ERROR:
         // Explicitly log errors
         Serial.printf("[WSc] Error: %s\n", payload);
         break;
     case WStype_FRAGMENT_TEXT_START:
-        Serial.println("[WSc] Fragmented text start");
-        break;
     case WStype_FRAGMENT_BIN_START:
-        Serial.println("[WSc] Fragmented bin start");
+        if (!ws_reassembly_begin(&ws_fragments, type == WStype_FRAGMENT_BIN_START, payload, length)) {
+            Serial.printf("[WSc] Fragmented message rejected (limit %u bytes)\n", (unsigned)ws_fragments.capacity);
+        }
         break;
     case WStype_FRAGMENT:
-        Serial.println("[WSc] Fragment received");
+        ws_reassembly_append(&ws_fragments, payload, length);
         break;
     case WStype_FRAGMENT_FIN:
-        Serial.println("[WSc] Fragment fin");
-        break;
+    {
+        uint8_t *msg;
+        size_t msg_len;
+        if (ws_reassembly_finish(&ws_fragments, payload, length, &msg, &msg_len)) {
+            if (ws_fragments.binary) handle_binary_frame(msg, msg_len);
+            else handle_text_message(msg, msg_len);
+        }
+    }
+    break;
     case WStype_PING:
         Serial.println("[WSc] Received ping");
         break;
@@ -343,6 +797,31 @@ void testWiFi()
     }
 }
 
+// Services the WebSocket (and decodes images) on NET_TASK_CORE, so neither
+// incoming images nor heavy drawing stall the other side.
+static void network_task(void *arg)
+{
+    for (;;)
+    {
+        webSocket.loop(); // MUST call this frequently to process WebSocket events
+        send_frame_ack(); // Frame pacing for the sender
+        send_sketch_reports();
+        save_trace_step();
+        vTaskDelay(1);
+    }
+}
+
+// Render loop side: applies the control updates the network task has queued
+static void drain_network_events()
+{
+    static ControlUpdate update; // Too large for the loop task's stack
+    while (control_queue.pop(update))
+    {
+        apply_control_message(update);
+    }
+    // New images need no draining: sketch.cpp picks up the published front buffer
+}
+
 void setup()
 {
     Serial.begin(115200);
@@ -352,6 +831,10 @@ void setup()
     // 1. Test Wi-Fi connection first
     testWiFi();
 
+    // Allocate the reusable JSON and fragment arenas before the heap gets fragmented
+    get_json_arena();
+    ws_reassembly_init(&ws_fragments, (uint8_t *)heap_tag_malloc(HEAP_TAG_NET, WS_FRAGMENT_ARENA_SIZE + 1, MALLOC_CAP_SPIRAM), WS_FRAGMENT_ARENA_SIZE);
+
     // --- Start WebSocket Client (only if WiFi connected) ---
     if (WiFi.status() == WL_CONNECTED)
     {
@@ -370,6 +853,7 @@ void setup()
             webSocket.onEvent(webSocketEvent);
             // Set reconnect interval in ms (optional)
             webSocket.setReconnectInterval(10000); // try every 10 seconds
+            websocket_started = true;
                                                    //   Start heartbeat (optional, helps keep connection alive)
                                                    //   webSocket.enableHeartbeat(15000, 3000, 2); // Send ping every 15s, timeout 3s, max 2 retries
         }
@@ -380,6 +864,7 @@ void setup()
     }
     // --- End Start WebSocket Client ---
 
+#if defined(ESP_PLATFORM)
     // 2. Initialize hardware peripherals needed for display/touch
     I2C_Init();
     TCA9554PWR_Init(0x00);
@@ -387,6 +872,7 @@ void setup()
 
     // 3. Initialize Display and LVGL *after* Wi-Fi attempt
     LCD_Init();
+#endif
     Lvgl_Init();
 
     // 4. Setup the sketch UI
@@ -395,12 +881,18 @@ void setup()
     // 5. Initialize the test pixel buffer with random colors
     init_test_pixel_buffer();
 
+    // 6. Hand WebSocket servicing and image decoding to the network task
+    if (websocket_started)
+    {
+        xTaskCreatePinnedToCore(network_task, "network", NET_TASK_STACK_SIZE, nullptr, NET_TASK_PRIORITY, &net_task_handle, NET_TASK_CORE);
+    }
+
     printf("\n *** Setup Complete *** \n\n");
 }
 
 void loop()
 {
-    webSocket.loop(); // MUST call this frequently to process WebSocket events
+    drain_network_events(); // Apply control updates and frames from the network task
     Lvgl_Loop();      // LVGL loop that handles ticks and rendering
     sketch_loop();
     delay(LVGL_TICK_PERIOD); // Keep this delay small
@@ -0,0 +1,139 @@
+#include "psram_pool.h"
+#include "critical_section.h"
+#include "heap_stats.h"
+#include <esp_heap_caps.h>
+
+#define POOL_CLASS_COUNT 41        // PSRAM_POOL_MIN_BLOCK to PSRAM_POOL_MAX_BLOCK, 4 classes per octave
+#define POOL_DIRECT_CLASS 0xFFFF   // Oversized block, allocated and freed directly
+#define POOL_MAGIC 0x50534D50u     // "PSMP"
+
+// Sits in front of every block; the caller's pointer starts right after it
+struct alignas(16) BlockHeader {
+    uint32_t magic;
+    uint16_t size_class;
+    size_t size;        // Usable bytes after the header
+    BlockHeader* next;  // Free list link while the block is in the pool
+};
+
+static BlockHeader* free_lists[POOL_CLASS_COUNT];
+static uint8_t free_counts[POOL_CLASS_COUNT];
+static PsramPoolStats stats;
+static CriticalSection pool_lock; // Short sections only; heap calls happen outside it
+
+static size_t class_size(int k) {
+    if (k == 0) return PSRAM_POOL_MIN_BLOCK;
+    int octave = (k - 1) / 4;
+    int step = (k - 1) % 4 + 1;
+    return ((size_t)PSRAM_POOL_MIN_BLOCK << octave) * (4 + step) / 4;
+}
+
+static int class_for(size_t size) {
+    for (int k = 0; k < POOL_CLASS_COUNT; ++k) {
+        if (size <= class_size(k)) return k;
+    }
+    return -1;
+}
+
+static BlockHeader* heap_alloc(size_t size, HeapTag tag) {
+    BlockHeader* h = (BlockHeader*)heap_tag_malloc(tag, sizeof(BlockHeader) + size, MALLOC_CAP_SPIRAM);
+    if (!h) {
+        // Cached blocks may be what stands between us and a large enough hole
+        psram_pool_trim();
+        h = (BlockHeader*)heap_tag_malloc(tag, sizeof(BlockHeader) + size, MALLOC_CAP_SPIRAM);
+    }
+    return h;
+}
+
+void* psram_pool_alloc(size_t size, HeapTag tag) {
+    if (size == 0) size = 1;
+    int k = class_for(size);
+    size_t block = k >= 0 ? class_size(k) : size;
+
+    if (k >= 0) {
+        pool_lock.lock();
+        BlockHeader* h = free_lists[k];
+        if (h) {
+            free_lists[k] = h->next;
+            free_counts[k]--;
+            stats.hits++;
+            stats.bytes_held -= block;
+            stats.bytes_in_use += block;
+            pool_lock.unlock();
+            return h + 1;
+        }
+        pool_lock.unlock();
+    }
+
+    BlockHeader* h = heap_alloc(block, tag);
+    if (!h) return nullptr;
+    h->magic = POOL_MAGIC;
+    h->size_class = k >= 0 ? (uint16_t)k : POOL_DIRECT_CLASS;
+    h->size = block;
+    h->next = nullptr;
+
+    pool_lock.lock();
+    stats.misses++;
+    stats.bytes_in_use += block;
+    pool_lock.unlock();
+    return h + 1;
+}
+
+void psram_pool_free(void* ptr) {
+    if (!ptr) return;
+    BlockHeader* h = (BlockHeader*)ptr - 1;
+    if (h->magic != POOL_MAGIC) return; // Not ours (or already corrupted); leaking beats a bad free
+
+    pool_lock.lock();
+    stats.bytes_in_use -= h->size;
+    int k = h->size_class;
+    if (k != POOL_DIRECT_CLASS && free_counts[k] < PSRAM_POOL_MAX_FREE_PER_CLASS &&
+        stats.bytes_held + h->size <= PSRAM_POOL_MAX_HELD) {
+        h->next = free_lists[k];
+        free_lists[k] = h;
+        free_counts[k]++;
+        stats.bytes_held += h->size;
+        h = nullptr;
+    }
+    pool_lock.unlock();
+
+    if (h) {
+        h->magic = 0;
+        heap_tag_free(h);
+    }
+}
+
+size_t psram_pool_block_size(const void* ptr) {
+    if (!ptr) return 0;
+    const BlockHeader* h = (const BlockHeader*)ptr - 1;
+    return h->magic == POOL_MAGIC ? h->size : 0;
+}
+
+void psram_pool_trim() {
+    BlockHeader* released = nullptr;
+    pool_lock.lock();
+    for (int k = 0; k < POOL_CLASS_COUNT; ++k) {
+        while (free_lists[k]) {
+            BlockHeader* h = free_lists[k];
+            free_lists[k] = h->next;
+            h->next = released;
+            released = h;
+        }
+        free_counts[k] = 0;
+    }
+    stats.bytes_held = 0;
+    pool_lock.unlock();
+
+    while (released) {
+        BlockHeader* next = released->next;
+        released->magic = 0;
+        heap_tag_free(released);
+        released = next;
+    }
+}
+
+void psram_pool_get_stats(PsramPoolStats* out) {
+    pool_lock.lock();
+    *out = stats;
+    pool_lock.unlock();
+    out->largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+}
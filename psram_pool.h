@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "heap_stats.h"
+
+// Size-classed pool of PSRAM blocks for large per-message buffers (decoded
+// images, base64 scratch). Freed blocks are kept on a per-class free list and
+// handed out again, so a steady stream of similar messages stops allocating
+// from the PSRAM heap after the first few frames and does not fragment it.
+//
+// Classes start at PSRAM_POOL_MIN_BLOCK and grow in quarter-octave steps
+// (4, 5, 6, 7, 8 KB, 10 KB, ...), so at most ~25% of a block is wasted.
+// Requests larger than PSRAM_POOL_MAX_BLOCK bypass the pool.
+// All functions are safe to call from any task.
+
+#define PSRAM_POOL_MIN_BLOCK (4 * 1024)
+#define PSRAM_POOL_MAX_BLOCK (4 * 1024 * 1024)
+#define PSRAM_POOL_MAX_FREE_PER_CLASS 2            // Free blocks kept per size class
+#define PSRAM_POOL_MAX_HELD (3 * 1024 * 1024)     // Free bytes kept across all classes
+
+struct PsramPoolStats {
+    uint32_t hits;             // Allocations served from a free list
+    uint32_t misses;           // Allocations that went to the PSRAM heap
+    size_t bytes_in_use;       // Bytes in blocks currently handed out
+    size_t bytes_held;         // Bytes in free blocks kept by the pool
+    size_t largest_free_block; // Largest block the PSRAM heap could still allocate
+};
+
+// Returns a block of at least size bytes, or nullptr if PSRAM is exhausted.
+// If the heap allocation fails, the pool's free blocks are released and the
+// allocation is retried once. Blocks the pool allocates are counted against
+// tag in heap_stats.h.
+void* psram_pool_alloc(size_t size, HeapTag tag);
+
+// Returns a block to the pool (or to the heap if the pool is full). nullptr is ignored.
+void psram_pool_free(void* ptr);
+
+// Usable size of a block returned by psram_pool_alloc (its size class).
+size_t psram_pool_block_size(const void* ptr);
+
+// Releases all free blocks back to the PSRAM heap.
+void psram_pool_trim();
+
+void psram_pool_get_stats(PsramPoolStats* stats);
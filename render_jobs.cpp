@@ -0,0 +1,149 @@
+#include "render_jobs.h"
+#include <atomic>
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// A batch is OPEN from the moment the worker is woken until the caller has run
+// out of jobs. The worker joins only by moving OPEN to JOINED, and the caller
+// closes a batch the worker never joined by moving OPEN back to IDLE, so a
+// late wake-up can never touch the next batch's state.
+enum BatchPhase { PHASE_IDLE, PHASE_OPEN, PHASE_JOINED };
+
+static RenderJobFn job_fn;
+static void* job_ctx;
+static int job_count;
+static std::atomic<int> job_next{0};
+static std::atomic<int> phase{PHASE_IDLE};
+
+static bool worker_running = false;
+static bool worker_enabled = true;
+static unsigned stat_batches = 0;
+static unsigned stat_jobs = 0;
+static std::atomic<unsigned> stat_worker_jobs{0};
+
+// Runs jobs until none are left; returns how many this task ran
+static int take_jobs() {
+    int ran = 0;
+    for (;;) {
+        int i = job_next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= job_count) return ran;
+        job_fn(job_ctx, i);
+        ran++;
+    }
+}
+
+static void join_batch() {
+    int expected = PHASE_OPEN;
+    if (!phase.compare_exchange_strong(expected, PHASE_JOINED, std::memory_order_acquire)) return;
+    stat_worker_jobs.fetch_add(take_jobs(), std::memory_order_relaxed);
+    phase.store(PHASE_IDLE, std::memory_order_release); // Publishes the pixels written by the jobs
+}
+
+#if defined(ESP_PLATFORM)
+static SemaphoreHandle_t wake_sem = nullptr;
+
+static void wake_worker() {
+    xSemaphoreGive(wake_sem);
+}
+
+// The worker is on the other core: spin
+static inline void wait_pause(int& spins) {
+    (void)spins;
+}
+
+static void worker_task(void* arg) {
+    for (;;) {
+        xSemaphoreTake(wake_sem, portMAX_DELAY);
+        join_batch();
+    }
+}
+
+bool render_jobs_init() {
+    if (worker_running) return true;
+    wake_sem = xSemaphoreCreateBinary();
+    if (!wake_sem) return false;
+    worker_running = xTaskCreatePinnedToCore(worker_task, "render", RENDER_JOBS_STACK_SIZE, nullptr,
+                                             RENDER_JOBS_PRIORITY, nullptr, RENDER_JOBS_CORE) == pdPASS;
+    return worker_running;
+}
+#else
+// Never destroyed: the worker is still waiting on them when the process exits
+static std::mutex& wake_mutex = *new std::mutex;
+static std::condition_variable& wake_cv = *new std::condition_variable;
+static bool wake_pending = false;
+
+static void wake_worker() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake_pending = true;
+    }
+    wake_cv.notify_one();
+}
+
+// Spins briefly, then sleeps so the worker gets the CPU on single-core hosts
+static inline void wait_pause(int& spins) {
+    if (++spins < 64) return;
+    spins = 0;
+    std::this_thread::sleep_for(std::chrono::microseconds(1));
+}
+
+static void worker_task() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake_cv.wait(lock, [] { return wake_pending; });
+            wake_pending = false;
+        }
+        join_batch();
+    }
+}
+
+bool render_jobs_init() {
+    if (worker_running) return true;
+    std::thread(worker_task).detach();
+    worker_running = true;
+    return true;
+}
+#endif
+
+void render_jobs_run(RenderJobFn fn, void* ctx, int count) {
+    if (count <= 0) return;
+    stat_batches++;
+    stat_jobs += count;
+    if (!worker_running || !worker_enabled || count == 1) {
+        for (int i = 0; i < count; ++i) fn(ctx, i);
+        return;
+    }
+
+    job_fn = fn;
+    job_ctx = ctx;
+    job_count = count;
+    job_next.store(0, std::memory_order_relaxed);
+    phase.store(PHASE_OPEN, std::memory_order_release);
+    wake_worker();
+    take_jobs();
+
+    // Barrier: close the batch, or wait for the worker to finish the job it is on
+    int expected = PHASE_OPEN;
+    if (phase.compare_exchange_strong(expected, PHASE_IDLE, std::memory_order_relaxed)) return;
+    int spins = 0;
+    while (phase.load(std::memory_order_acquire) != PHASE_IDLE) wait_pause(spins);
+}
+
+void render_jobs_set_enabled(bool enabled) {
+    worker_enabled = enabled;
+}
+
+void render_jobs_get_stats(RenderJobStats* stats) {
+    stats->batches = stat_batches;
+    stats->jobs = stat_jobs;
+    stats->worker_jobs = stat_worker_jobs.load(std::memory_order_relaxed);
+}
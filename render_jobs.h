@@ -0,0 +1,38 @@
+#pragma once
+
+// Fork-join job system for splitting the canvas rasterization across both
+// cores.
+//
+// render_jobs_run() hands out job indices 0..count-1 to the calling task and
+// to a worker task pinned to the other core. Each takes the next index from a
+// shared atomic counter until none are left, so if the worker's core is busy
+// (the network task shares core 0) the caller simply runs more of the jobs.
+// It returns once every job has finished, which makes it the barrier before
+// the results are used.
+//
+// On the ESP32 the worker is a FreeRTOS task; on the host it is a std::thread,
+// so the same code can be tested there.
+
+#define RENDER_JOBS_CORE 0                // Worker core; the render loop runs on the other one
+#define RENDER_JOBS_PRIORITY 2            // Same as the network task, so the two time-slice
+#define RENDER_JOBS_STACK_SIZE (4 * 1024)
+
+typedef void (*RenderJobFn)(void* ctx, int index);
+
+// Starts the worker. Until it runs (or if it failed to start), jobs run on the caller alone.
+bool render_jobs_init();
+
+// Runs fn(ctx, i) for every i in 0..count-1 and waits for all of them. Jobs
+// must be independent. Only one task may call this.
+void render_jobs_run(RenderJobFn fn, void* ctx, int count);
+
+// Lets the worker take jobs or not ("cores 1" / "cores 2").
+void render_jobs_set_enabled(bool enabled);
+
+struct RenderJobStats {
+    unsigned batches;     // render_jobs_run calls
+    unsigned jobs;        // jobs run in total
+    unsigned worker_jobs; // jobs run by the worker
+};
+
+void render_jobs_get_stats(RenderJobStats* stats);
@@ -0,0 +1,108 @@
+#include "rgb565_blend.h"
+#include <string.h>
+
+#define RGB565_FIELDS 0x07E0F81Fu // Low pixel's B (bits 0-4) and R (11-15), high pixel's G (21-26)
+
+// Pixel pairs are loaded and stored with memcpy: spans may start at any
+// 16-bit address and the compiler turns these into single 32-bit accesses
+
+static inline uint32_t load2(const uint16_t* p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline void store2(uint16_t* p, uint32_t w) {
+    memcpy(p, &w, sizeof(w));
+}
+
+// Swaps the two pixels of a pair, so the other pixel's R/B land in the field positions
+static inline uint32_t rot16(uint32_t w) {
+    return (w >> 16) | (w << 16);
+}
+
+// Blends a pixel pair: fg_lo/fg_hi are the foreground's two field groups
+// already multiplied by the alpha, ia is 32 - alpha
+static inline uint32_t blend2(uint32_t bg, uint32_t fg_lo, uint32_t fg_hi, uint32_t ia) {
+    uint32_t lo = (((bg & RGB565_FIELDS) * ia + fg_lo) >> 5) & RGB565_FIELDS;
+    uint32_t hi = (((rot16(bg) & RGB565_FIELDS) * ia + fg_hi) >> 5) & RGB565_FIELDS;
+    return lo | rot16(hi);
+}
+
+static void fill(uint16_t* dst, int n, uint16_t color) {
+    if ((uintptr_t)dst & 2) {
+        *dst++ = color;
+        n--;
+    }
+    uint32_t pair = color | ((uint32_t)color << 16);
+    for (; n >= 2; n -= 2, dst += 2) store2(dst, pair);
+    if (n) *dst = color;
+}
+
+void rgb565_fill_alpha(uint16_t* dst, int n, uint16_t color, uint8_t opa) {
+    uint32_t a = rgb565_alpha(opa);
+    if (n <= 0 || a == 0) return;
+    if (a >= 32) {
+        fill(dst, n, color);
+        return;
+    }
+
+    if ((uintptr_t)dst & 2) {
+        *dst = rgb565_blend_pixel(*dst, color, a);
+        dst++;
+        n--;
+    }
+    // Both pixels of the pair are the same colour, so both field groups are too
+    uint32_t fg = ((color | ((uint32_t)color << 16)) & RGB565_FIELDS) * a;
+    uint32_t ia = 32 - a;
+    for (; n >= 2; n -= 2, dst += 2) store2(dst, blend2(load2(dst), fg, fg, ia));
+    if (n) *dst = rgb565_blend_pixel(*dst, color, a);
+}
+
+void rgb565_fill_mask(uint16_t* dst, int n, uint16_t color, const uint8_t* mask, uint8_t opa) {
+    if (n <= 0 || opa == 0) return;
+    uint32_t pair = color | ((uint32_t)color << 16);
+    uint32_t fields = pair & RGB565_FIELDS;
+
+    int i = 0;
+    if ((uintptr_t)dst & 2) {
+        dst[0] = rgb565_blend_pixel(dst[0], color, (opa * mask[0] + 1024u) >> 11);
+        i = 1;
+    }
+    for (; i + 1 < n; i += 2) {
+        uint32_t a0 = (opa * mask[i] + 1024u) >> 11;
+        uint32_t a1 = (opa * mask[i + 1] + 1024u) >> 11;
+        if ((a0 | a1) == 0) continue;
+        if (a0 == a1) {
+            // Runs of equal coverage (fully inside or outside a shape) are the common case
+            if (a0 >= 32) store2(dst + i, pair);
+            else store2(dst + i, blend2(load2(dst + i), fields * a0, fields * a0, 32 - a0));
+        } else {
+            dst[i] = rgb565_blend_pixel(dst[i], color, a0);
+            dst[i + 1] = rgb565_blend_pixel(dst[i + 1], color, a1);
+        }
+    }
+    if (i < n) dst[i] = rgb565_blend_pixel(dst[i], color, (opa * mask[i] + 1024u) >> 11);
+}
+
+void rgb565_copy_alpha(uint16_t* dst, const uint16_t* src, int n, uint8_t opa) {
+    uint32_t a = rgb565_alpha(opa);
+    if (n <= 0 || a == 0) return;
+    if (a >= 32) {
+        memcpy(dst, src, n * sizeof(uint16_t));
+        return;
+    }
+
+    if ((uintptr_t)dst & 2) {
+        *dst = rgb565_blend_pixel(*dst, *src, a);
+        dst++;
+        src++;
+        n--;
+    }
+    uint32_t ia = 32 - a;
+    for (; n >= 2; n -= 2, dst += 2, src += 2) {
+        uint32_t s = load2(src);
+        store2(dst, blend2(load2(dst), (s & RGB565_FIELDS) * a, (rot16(s) & RGB565_FIELDS) * a, ia));
+    }
+    if (n) *dst = rgb565_blend_pixel(*dst, *src, a);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// RGB565 span kernels for the custom layers: fill with alpha, fill through a
+// per-pixel coverage mask, and copy with a constant alpha.
+//
+// Blending uses 5-bit alpha, (opa + 4) >> 3, applied per channel as
+// (bg * (32 - a) + fg * a) >> 5, so every kernel matches the scalar
+// rgb565_blend_pixel exactly. Spans are processed two pixels per 32-bit word:
+// the word is split into two groups of fields with 5 spare bits above each
+// (R/B of one pixel with G of the other), so a pair of pixels costs two
+// multiplications for a constant colour. Opacity 255 stores without blending
+// and opacity below 4 leaves the span untouched.
+// Spans may start at any pixel address.
+
+// Blends one pixel; a is the 5-bit alpha (0..32).
+static inline uint16_t rgb565_blend_pixel(uint16_t bg, uint16_t fg, uint32_t a) {
+    uint32_t b = (bg | ((uint32_t)bg << 16)) & 0x07E0F81Fu;
+    uint32_t f = (fg | ((uint32_t)fg << 16)) & 0x07E0F81Fu;
+    uint32_t v = ((b * (32 - a) + f * a) >> 5) & 0x07E0F81Fu;
+    return (uint16_t)(v | (v >> 16));
+}
+
+static inline uint32_t rgb565_alpha(uint8_t opa) {
+    return (opa + 4u) >> 3;
+}
+
+// dst[i] = color blended over dst[i] with opa.
+void rgb565_fill_alpha(uint16_t* dst, int n, uint16_t color, uint8_t opa);
+
+// dst[i] = color blended over dst[i] with coverage mask[i] (0..255): the
+// 5-bit alpha is (opa * mask[i] + 1024) >> 11.
+void rgb565_fill_mask(uint16_t* dst, int n, uint16_t color, const uint8_t* mask, uint8_t opa);
+
+// dst[i] = src[i] blended over dst[i] with opa.
+void rgb565_copy_alpha(uint16_t* dst, const uint16_t* src, int n, uint8_t opa);
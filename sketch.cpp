@@ -1,12 +1,28 @@
 #include "sketch.h"
 #include <Arduino.h>
 #include <lvgl.h>
+#include <atomic>
+#include <limits.h>
 #include "esp_heap_caps.h"
 #include "base64_utils.h"
+#include "image_buffer.h"
+#include "psram_pool.h"
+#include "heap_stats.h"
+#include "image_scaler.h"
+#include "dirty_rects.h"
+#include "display_list.h"
+#include "render_jobs.h"
+#include "frame_scheduler.h"
+#include "stage_timer.h"
+#include "spsc_queue.h"
+#include "layer_rng.h"
+#include "LVGL_Driver.h"
 
 #define CANVAS_WIDTH 480
 #define CANVAS_HEIGHT 480
-#define UPDATE_PERIOD 100 // milliseconds
+#define UPDATE_PERIOD 100 // milliseconds, default frame period ("fps <n>")
+#define LAYER_BUDGET_PERCENT 50 // Share of the frame period the layers may use; LVGL needs the rest to render and flush
+#define SCHED_REPORT_PERIOD 1000 // milliseconds between {"type":"sched"} and {"type":"stats"} reports
 #define LVGL_TICK_PERIOD 5
 
 // Define extern variables declared in sketch.h
@@ -14,20 +30,19 @@ extern char ip_address_str[16];
 extern float ws_slider_value;
 extern float ws_number_value;
 extern char ws_text_value[1024];
-extern int received_image_width;  // Definition for variable from sketch.h
-extern int received_image_height; // Definition for variable from sketch.h
 
-// Extern declarations for global variables defined in the .ino file
-// extern uint16_t* decoded_img_buffer; // This is defined in .ino
-// extern size_t decoded_img_size; // This is defined in .ino
-// extern volatile bool new_image_available; // This is defined in .ino
+// The decoded image comes from image_buffer.h: each frame pins the current
+// front buffer with image_buffer_acquire() and releases it when done, so the
+// network task can decode the next image concurrently.
+static uint32_t r0_drawn_seq = 0; // seq of the image last drawn as background
+static bool r0_on_canvas = false;  // that image is still on the canvas (not cleared), so tile updates can patch it
+static ImageScaler r0_scaler;      // Column tables for the current image size, rebuilt when it changes
+static ImageScaleMode r0_scale_mode = IMAGE_SCALE_NEAREST; // "r0 filter nearest|bilinear|area"
 
-// Definitions for variables declared extern in sketch.h
-// uint16_t* decoded_img_buffer = nullptr; // REMOVE THIS LINE
-int decoded_img_width = 16;             // Definition and initial value for test buffer
-int decoded_img_height = 16;            // Definition and initial value for test buffer
-// size_t decoded_img_size = 0;            // REMOVE THIS LINE
-// volatile bool new_image_available = true; // REMOVE THIS LINE
+// Image resolution the layers can use, read by the network task (see sketch_get_image_target)
+static std::atomic<int> image_target_width{CANVAS_WIDTH};
+static std::atomic<int> image_target_height{CANVAS_HEIGHT};
+static int image_grid_side = 0; // "imgres <n>": r4/r5 image resolution when r0 is off, 0 = canvas resolution
 
 // Drawing algorithm toggles
 static bool draw_r0_enabled = false;  // image background
@@ -41,9 +56,41 @@ static lv_obj_t *canvas;
 static lv_color_t *cbuf = nullptr;
 
 static lv_obj_t* img_widget = nullptr;
-// int decoded_img_width = 0;
-// int decoded_img_height = 0;
 
+// Areas of the canvas the layers drew into this frame; only these are invalidated
+static DirtyRects frame_dirty;
+
+// The layers record their primitives here and the list is rasterized into cbuf
+// tile by tile at the end of the frame, or earlier when the arena fills up (display_list.h)
+#define FRAME_LIST_BYTES (32 * 1024)
+static DisplayList frame_list;
+
+// Frame scheduler: measures every layer and cuts the work of r4 (dots) and r5
+// (grid cells) to what fits in the layer budget (frame_scheduler.h)
+static const char* const layer_names[LAYER_COUNT] = { "r0", "r1", "r2", "r3", "r4", "r5" };
+static FrameScheduler frame_sched;
+static lv_timer_t* frame_timer = nullptr;
+static uint32_t frame_period_ms = UPDATE_PERIOD;
+static uint32_t sched_report_ms = 0; // millis() of the last report
+static int r5_next_cell = 0;          // r5 draws its grid from here on when it cannot draw all cells in a frame
+
+// One random stream per layer (layer_rng.h), so a seed ("seed <n>") repeats
+// each layer's pictures whatever the other layers draw
+static Rng layer_rng[LAYER_COUNT];
+#define R4_BATCH 64 // r4 dot positions generated per rng_fill_below call
+
+// Messages for the WebSocket, sent by the network task (sketch_pop_report)
+struct SketchReport {
+    char json[SKETCH_REPORT_MAX];
+};
+static SpscQueue<SketchReport, 4> report_queue; // render loop -> network task
+
+// Sets the frame period; the layers get LAYER_BUDGET_PERCENT of it
+static void set_frame_period(uint32_t period_ms) {
+    frame_period_ms = period_ms;
+    frame_sched.budget_us = period_ms * 1000 / 100 * LAYER_BUDGET_PERCENT;
+    if (frame_timer) lv_timer_set_period(frame_timer, period_ms);
+}
 
 static const lv_color_t palette[] = {
     lv_color_make(128, 0, 0),   // maroon
@@ -81,9 +128,31 @@ static void ip_label_delete_timer_cb(lv_timer_t * timer) {
     }
 }
 
-float frand(float a, float b)
+static float frand(Rng* rng, float a, float b)
+{
+  return a + rng_unit(rng) * (b - a);
+}
+
+void sketch_seed(uint32_t seed)
 {
-  return a + ((float)random(0, 10000) / 10000.0f) * (b - a);
+  for (int i = 0; i < LAYER_COUNT; ++i) rng_seed(&layer_rng[i], seed, i);
+}
+
+void sketch_get_image_target(int* width, int* height) {
+    *width = image_target_width.load(std::memory_order_relaxed);
+    *height = image_target_height.load(std::memory_order_relaxed);
+}
+
+// r0 draws at canvas resolution, so it always needs the full canvas size. r4 and r5
+// sample one color per grid cell and can do with a smaller image if "imgres" asks for it.
+static void update_image_target() {
+    int w = CANVAS_WIDTH;
+    int h = CANVAS_HEIGHT;
+    if (!draw_r0_enabled && image_grid_side > 0) {
+        w = h = image_grid_side;
+    }
+    image_target_width.store(w, std::memory_order_relaxed);
+    image_target_height.store(h, std::memory_order_relaxed);
 }
 
 // Example: Use slider value to control line width range in draw_r1
@@ -106,6 +175,7 @@ static void process_text_commands() {
             if (canvas && cbuf) {
                 lv_canvas_fill_bg(canvas, lv_color_hex(0x000000), LV_OPA_COVER); // Clear to black
                 lv_obj_invalidate(canvas);
+                r0_on_canvas = false;
                 Serial.println("[Sketch] Canvas cleared.");
                 clear_command_processed = true;
             }
@@ -117,6 +187,14 @@ static void process_text_commands() {
         // Toggle drawing modes
         else if (currentTextValue == "r0 on") { draw_r0_enabled = true; Serial.println("[Sketch] Image Background (r0) enabled"); }
         else if (currentTextValue == "r0 off") { draw_r0_enabled = false; Serial.println("[Sketch] Image Background (r0) disabled"); }
+        else if (currentTextValue.startsWith("r0 filter ")) {
+            String mode = currentTextValue.substring(10);
+            if (mode == "nearest") r0_scale_mode = IMAGE_SCALE_NEAREST;
+            else if (mode == "bilinear") r0_scale_mode = IMAGE_SCALE_BILINEAR;
+            else if (mode == "area") r0_scale_mode = IMAGE_SCALE_AREA;
+            Serial.printf("[Sketch] Image Background (r0) filter: %s\n", mode.c_str());
+            r0_drawn_seq = 0; // Redraw the current image with the new filter
+        }
         else if (currentTextValue == "r1 on") { draw_r1_enabled = true; Serial.println("[Sketch] Random Lines (r1) enabled"); }
         else if (currentTextValue == "r1 off") { draw_r1_enabled = false; Serial.println("[Sketch] Random Lines (r1) disabled"); }
         else if (currentTextValue == "r2 on") { draw_r2_enabled = true; Serial.println("[Sketch] Random Triangles (r2) enabled"); }
@@ -127,8 +205,58 @@ static void process_text_commands() {
         else if (currentTextValue == "r4 off") { draw_r4_enabled = false; Serial.println("[Sketch] Small Circles (r4) disabled"); }
         else if (currentTextValue == "r5 on") { draw_r5_enabled = true; Serial.println("[Sketch] Pointillist Image (r5) enabled"); }
         else if (currentTextValue == "r5 off") { draw_r5_enabled = false; Serial.println("[Sketch] Pointillist Image (r5) disabled"); }
+        else if (currentTextValue == "pool") {
+            PsramPoolStats s;
+            psram_pool_get_stats(&s);
+            Serial.printf("[Sketch] PSRAM pool: %u hits, %u misses, %u bytes in use, %u bytes held, largest free block %u\n",
+                          (unsigned)s.hits, (unsigned)s.misses, (unsigned)s.bytes_in_use, (unsigned)s.bytes_held,
+                          (unsigned)s.largest_free_block);
+        }
+        else if (currentTextValue == "frames") {
+            ImagePresentStats s;
+            image_buffer_get_present_stats(&s);
+            Serial.printf("[Sketch] Frames: %u presented, %u dropped, last frame %u\n",
+                          (unsigned)s.presented, (unsigned)s.dropped, (unsigned)s.frame_id);
+        }
+        else if (currentTextValue == "cores 1" || currentTextValue == "cores 2") {
+            render_jobs_set_enabled(currentTextValue == "cores 2");
+            RenderJobStats s;
+            render_jobs_get_stats(&s);
+            Serial.printf("[Sketch] Rendering on %s; %u jobs so far, %u on the second core\n",
+                          currentTextValue == "cores 2" ? "both cores" : "one core", s.jobs, s.worker_jobs);
+        }
+        else if (currentTextValue == "bench strips") {
+            Lvgl_Bench_Strips(10);
+        }
+        else if (currentTextValue.startsWith("imgres ")) {
+            image_grid_side = constrain(currentTextValue.substring(7).toInt(), 0, CANVAS_WIDTH);
+            Serial.printf("[Sketch] Image resolution for r4/r5 set to %d (0 = canvas)\n", image_grid_side);
+        }
+        else if (currentTextValue.startsWith("fps ")) {
+            int fps = constrain(currentTextValue.substring(4).toInt(), 1, 60);
+            set_frame_period(1000 / fps);
+            Serial.printf("[Sketch] Frame period %u ms, layer budget %u us\n", (unsigned)frame_period_ms,
+                          (unsigned)frame_sched.budget_us);
+        }
+        else if (currentTextValue.startsWith("budget ")) {
+            frame_sched.budget_us = max(1, (int)currentTextValue.substring(7).toInt()) * 1000;
+            Serial.printf("[Sketch] Layer budget %u us per frame\n", (unsigned)frame_sched.budget_us);
+        }
+        else if (currentTextValue.startsWith("seed ")) {
+            uint32_t seed = strtoul(currentTextValue.substring(5).c_str(), nullptr, 10);
+            sketch_seed(seed);
+            Serial.printf("[Sketch] Layers reseeded with %u\n", (unsigned)seed);
+        }
+        else if (currentTextValue == "sched") {
+            char json[SKETCH_REPORT_MAX];
+            if (frame_scheduler_format(&frame_sched, layer_names, frame_period_ms, json, sizeof(json))) {
+                Serial.println(json);
+            }
+        }
         // Add other text commands here if needed
 
+        update_image_target(); // r0 and imgres change the image size worth decoding
+
         // After processing any command other than "clear", reset ws_text_value if it's not a persistent state
         // For toggle commands like "r1 on/off", we don't need to reset ws_text_value immediately,
         // as lastTextValue check prevents re-processing.
@@ -136,45 +264,81 @@ static void process_text_commands() {
     }
 }
 
-void check_image_update() {
+// A region of the scaled image, split into horizontal bands for render_jobs_run
+#define IMAGE_BAND_ROWS 32 // Smallest band worth handing to the other core
+#define IMAGE_MAX_BANDS 16
+struct ImageAreaJob {
+    const ImageFrame* img;
+    uint16_t* dst;
+    int x0, y0, x1, y1;
+    int bands;
+};
+
+static void image_band_job(void* ctx, int band) {
+    const ImageAreaJob* job = (const ImageAreaJob*)ctx;
+    int rows = job->y1 - job->y0;
+    image_scaler_run(&r0_scaler, job->img->pixels, job->dst, CANVAS_WIDTH, job->x0,
+                     job->y0 + rows * band / job->bands, job->x1, job->y0 + rows * (band + 1) / job->bands);
+}
+
+// Draws the part of the image that covers columns [x0, x1) and rows [y0, y1)
+// of the scaled (fit, centered) image area into the canvas buffer, using
+// r0_scale_mode, in bands on both cores. The scaler's lookup tables are only
+// rebuilt when the image size or mode changes.
+static void draw_image_area(const ImageFrame* img, int x0, int y0, int x1, int y1) {
+    float scale = fminf((float)CANVAS_WIDTH / img->width, (float)CANVAS_HEIGHT / img->height);
+    int draw_w = (int)(img->width * scale);
+    int draw_h = (int)(img->height * scale);
+    int x_off = (CANVAS_WIDTH - draw_w) / 2;
+    int y_off = (CANVAS_HEIGHT - draw_h) / 2;
+    if (!image_scaler_setup(&r0_scaler, img->width, img->height, draw_w, draw_h, r0_scale_mode)) return;
+
+    ImageAreaJob job;
+    job.img = img;
+    job.dst = (uint16_t*)cbuf + y_off * CANVAS_WIDTH + x_off; // LV_COLOR_DEPTH 16: lv_color_t is RGB565
+    job.x0 = x0;
+    job.y0 = y0;
+    job.x1 = x1;
+    job.y1 = y1;
+    job.bands = constrain((y1 - y0) / IMAGE_BAND_ROWS, 1, IMAGE_MAX_BANDS);
+    render_jobs_run(image_band_job, &job, job.bands);
+}
+
+// Redraws only the regions that changed since the previous image and invalidates
+// just those canvas areas (the image must directly follow the one last drawn)
+static void draw_image_dirty_rects(const ImageFrame* img) {
+    float scale = fminf((float)CANVAS_WIDTH / img->width, (float)CANVAS_HEIGHT / img->height);
+    int x_off = (CANVAS_WIDTH - (int)(img->width * scale)) / 2;
+    int y_off = (CANVAS_HEIGHT - (int)(img->height * scale)) / 2;
+    lv_area_t canvas_coords;
+    lv_obj_get_coords(canvas, &canvas_coords);
+
+    // Widen by a pixel to absorb rounding; bilinear also blends in the neighbouring source pixels
+    int margin = r0_scale_mode == IMAGE_SCALE_BILINEAR ? (int)ceilf(scale) + 1 : 1;
+
+    for (int i = 0; i < img->dirty_count; ++i) {
+        const ImageRect& r = img->dirty[i];
+        int x0 = (int)(r.x * scale) - margin;
+        int y0 = (int)(r.y * scale) - margin;
+        int x1 = (int)ceilf((r.x + r.w) * scale) + margin;
+        int y1 = (int)ceilf((r.y + r.h) * scale) + margin;
+        draw_image_area(img, x0, y0, x1, y1);
+
+        lv_area_t area;
+        area.x1 = canvas_coords.x1 + x_off + x0;
+        area.y1 = canvas_coords.y1 + y_off + y0;
+        area.x2 = canvas_coords.x1 + x_off + x1 - 1;
+        area.y2 = canvas_coords.y1 + y_off + y1 - 1;
+        lv_obj_invalidate_area(canvas, &area); // Clipped to the canvas by LVGL
+    }
+}
+
+// Draws img as the background if it is newer than the one on the canvas. img is
+// the frame the caller pinned for the whole frame. Returns true if it drew a new
+// image (or tiles of one) into the canvas.
+static bool check_image_update(const ImageFrame* img) {
     // r0: image background
-    if (draw_r0_enabled && new_image_available && decoded_img_buffer != nullptr && decoded_img_size > 0) {
-        
-        // --- Using global image width/height and RGB565 data ---
-        if (canvas && cbuf && decoded_img_width > 0 && decoded_img_height > 0) {
-        
-            // Draw image into the canvas buffer as the background (before generative art)
-            // This will be visible underneath all generative art overlays
-            lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
-            int src_w = decoded_img_width;
-            int src_h = decoded_img_height;
-            int dst_w = CANVAS_WIDTH;
-            int dst_h = CANVAS_HEIGHT;
-            float scale = fminf((float)dst_w / src_w, (float)dst_h / src_h);
-            int draw_w = (int)(src_w * scale);
-            int draw_h = (int)(src_h * scale);
-            int x_off = (dst_w - draw_w) / 2;
-            int y_off = (dst_h - draw_h) / 2;
-            uint16_t* src = (uint16_t*)decoded_img_buffer;
-            for (int y = 0; y < draw_h; ++y) {
-                int src_y = (int)(y / scale);
-                if (src_y >= src_h) src_y = src_h - 1;
-                for (int x = 0; x < draw_w; ++x) {
-                    int src_x = (int)(x / scale);
-                    if (src_x >= src_w) src_x = src_w - 1;
-                    uint16_t pixel = src[src_y * src_w + src_x];
-                    int dst_x = x + x_off;
-                    int dst_y = y + y_off;
-                    if (dst_x >= 0 && dst_x < dst_w && dst_y >= 0 && dst_y < dst_h) {
-                        cbuf[dst_y * dst_w + dst_x].full = pixel;
-                    }
-                }
-            }
-            // Do not call lv_obj_move_foreground/canvas layering here: canvas is always on top, image is drawn into canvas background
-            lv_obj_invalidate(canvas);
-        }
-        new_image_available = false;
-    } else if (!draw_r0_enabled) {
+    if (!draw_r0_enabled) {
         // If r0 is disabled, ensure the canvas area where the image would be is cleared
         // This assumes other drawing functions might not fully overwrite it.
         // If other functions always fill the canvas, this might not be strictly necessary,
@@ -184,7 +348,50 @@ void check_image_update() {
         // lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_TRANSP); // Clear to transparent white
         // For now, let's assume other drawing functions will cover it or a default bg is fine.
         // If you see artifacts when r0 is off, we'll add explicit clearing here.
+        return false;
     }
+
+    bool drawn = false;
+    if (img->seq != r0_drawn_seq && img->pixels != nullptr) {
+        
+        // --- Using the published image width/height and RGB565 data ---
+        if (canvas && cbuf && img->width > 0 && img->height > 0) {
+        
+            if (r0_on_canvas && img->seq == r0_drawn_seq + 1 && !img->dirty_all) {
+                // Tile update on top of the image already on the canvas
+                draw_image_dirty_rects(img);
+            } else {
+                // Draw image into the canvas buffer as the background (before generative art)
+                // This will be visible underneath all generative art overlays
+                lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+                draw_image_area(img, 0, 0, CANVAS_WIDTH, CANVAS_HEIGHT);
+                // Do not call lv_obj_move_foreground/canvas layering here: canvas is always on top, image is drawn into canvas background
+                lv_obj_invalidate(canvas);
+            }
+            r0_on_canvas = true;
+            drawn = true;
+        }
+        r0_drawn_seq = img->seq;
+    }
+    return drawn;
+}
+
+static void replay_band_job(void* ctx, int band) {
+    display_list_replay_band(&frame_list, (uint16_t*)cbuf, CANVAS_WIDTH, band); // LV_COLOR_DEPTH 16: lv_color_t is RGB565
+}
+
+// Rasterizes the primitives recorded so far into the canvas buffer, one band of
+// tiles per job on both cores, and empties the list
+static void flush_frame_list() {
+    if (cbuf && frame_list.count > 0) {
+        render_jobs_run(replay_band_job, nullptr, display_list_bin(&frame_list, CANVAS_WIDTH, CANVAS_HEIGHT));
+    }
+    display_list_reset(&frame_list);
+}
+
+// Called before recording a primitive: flushes the list if the largest record might not fit
+static void frame_list_make_room() {
+    if (frame_list.capacity - frame_list.used < DISPLAY_LIST_MAX_RECORD_SIZE) flush_frame_list();
 }
 
 // r1: Draws random lines on the canvas.
@@ -216,24 +423,17 @@ static void draw_r1()
     float range_w = 0.99f * (1.0f - center_offset_factor); // Smaller range if number is higher
     float range_h = 0.899 * (1.0f - center_offset_factor);
 
-    int x1 = frand(x - range_w / 2.0f, x + range_w / 2.0f) * CANVAS_WIDTH;
-    int y1 = frand(y - range_h / 2.0f, y + range_h / 2.0f) * CANVAS_HEIGHT;
-    int x2 = frand(x - range_w / 2.0f, x + range_w / 2.0f) * CANVAS_WIDTH;
-    int y2 = frand(y - range_h / 2.0f, y + range_h / 2.0f) * CANVAS_HEIGHT;
-
-    // Create an array of points for the line
-    lv_point_t line_points[] = { {x1, y1}, {x2, y2} };
+    Rng* rng = &layer_rng[LAYER_R1];
+    int x1 = frand(rng, x - range_w / 2.0f, x + range_w / 2.0f) * CANVAS_WIDTH;
+    int y1 = frand(rng, y - range_h / 2.0f, y + range_h / 2.0f) * CANVAS_HEIGHT;
+    int x2 = frand(rng, x - range_w / 2.0f, x + range_w / 2.0f) * CANVAS_WIDTH;
+    int y2 = frand(rng, y - range_h / 2.0f, y + range_h / 2.0f) * CANVAS_HEIGHT;
 
-    lv_draw_line_dsc_t line_dsc;
-    lv_draw_line_dsc_init(&line_dsc);
-    line_dsc.color = palette[random(0, palette_size)];
-    line_dsc.width = line_width; // Use the controlled width
-    line_dsc.round_start = 1;
-    line_dsc.round_end = 1;
-    line_dsc.opa = line_opa;
-
-    // Call the function with the points array and point count (2)
-    lv_canvas_draw_line(canvas, line_points, 2, &line_dsc);
+    // Line with round caps
+    frame_list_make_room();
+    display_list_line(&frame_list, x1, y1, x2, y2, line_width, palette[rng_below(rng, palette_size)].full, line_opa);
+    int pad = line_width / 2 + 1; // Round caps extend half the width past the end points
+    dirty_rects_add(&frame_dirty, min(x1, x2) - pad, min(y1, y2) - pad, max(x1, x2) + pad, max(y1, y2) + pad);
 
 }
 
@@ -243,14 +443,15 @@ static void draw_r1()
 // Controlled by `draw_r2_enabled` flag, toggled by "r2 on" / "r2 off" commands.
 static void draw_r2()
 {
+  Rng* rng = &layer_rng[LAYER_R2];
   lv_draw_rect_dsc_t fill_dsc;
   lv_draw_rect_dsc_init(&fill_dsc);
-  fill_dsc.bg_color = palette[random(0, palette_size)];
+  fill_dsc.bg_color = palette[rng_below(rng, palette_size)];
   fill_dsc.radius = LV_RADIUS_CIRCLE;
 
   int cx = CANVAS_WIDTH / 2;
   int cy = CANVAS_HEIGHT / 2;
-  int r = random(10, CANVAS_WIDTH / 3);
+  int r = rng_between(rng, 10, CANVAS_WIDTH / 3);
 
   // Number controls thickness (1-20)
   int min_arc_width = 1;
@@ -268,16 +469,14 @@ static void draw_r2()
   // Draw fill arc (optional)
   // lv_canvas_draw_arc(canvas, cx, cy, r, 0, 360, &fill_dsc);
 
-  lv_draw_arc_dsc_t dsc;
-  lv_draw_arc_dsc_init(&dsc);
-  dsc.color = palette[random(0, palette_size)];
-  dsc.width = arc_width; // Use controlled width
-  dsc.opa = arc_opa;
+  uint16_t arc_color = palette[rng_below(rng, palette_size)].full;
 
-  int start_angle = random(0, 360);
-  int end_angle = start_angle + random(30, 180); // Draw partial arcs
+  int start_angle = rng_below(rng, 360);
+  int end_angle = start_angle + rng_between(rng, 30, 180); // Draw partial arcs
 
-  lv_canvas_draw_arc(canvas, cx, cy, r, start_angle, end_angle, &dsc);
+  frame_list_make_room();
+  display_list_arc(&frame_list, cx, cy, r, arc_width, start_angle, end_angle, arc_color, arc_opa);
+  dirty_rects_add(&frame_dirty, cx - r, cy - r, cx + r, cy + r); // Width grows inwards from r
 }
 
 // r3: Draws random filled triangles on the canvas. (Note: previously arcs, function name was draw_r2, now correctly draw_r3)
@@ -294,11 +493,12 @@ void draw_r3() {
     if (ws_slider_value < 0.05f) return;
 
     // Center of triangle
-    float cx = frand(0.1f, 0.9f) * CANVAS_WIDTH;
-    float cy = frand(0.1f, 0.9f) * CANVAS_HEIGHT;
+    Rng* rng = &layer_rng[LAYER_R3];
+    float cx = frand(rng, 0.1f, 0.9f) * CANVAS_WIDTH;
+    float cy = frand(rng, 0.1f, 0.9f) * CANVAS_HEIGHT;
 
     // Random orientation
-    float angle = frand(0, 2 * 3.1415926f);
+    float angle = frand(rng, 0, 2 * 3.1415926f);
 
     // Vertices of equilateral triangle
     lv_point_t pts[3];
@@ -309,15 +509,22 @@ void draw_r3() {
     }
 
     // Color and opacity
-    lv_draw_rect_dsc_t dsc;
-    lv_draw_rect_dsc_init(&dsc);
-    dsc.bg_color = palette[random(0, palette_size)];
-    dsc.bg_opa = (lv_opa_t)(10 + ws_slider_value * (255 - 10));
-    dsc.border_opa = LV_OPA_TRANSP;
-    dsc.radius = 0;
+    uint16_t color = palette[rng_below(rng, palette_size)].full;
+    lv_opa_t opa = (lv_opa_t)(10 + ws_slider_value * (255 - 10));
 
     // Draw the triangle (filled polygon)
-    lv_canvas_draw_polygon(canvas, pts, 3, &dsc);
+    frame_list_make_room();
+    display_list_triangle(&frame_list, pts[0].x, pts[0].y, pts[1].x, pts[1].y, pts[2].x, pts[2].y, color, opa);
+    dirty_rects_add(&frame_dirty, min(pts[0].x, min(pts[1].x, pts[2].x)), min(pts[0].y, min(pts[1].y, pts[2].y)),
+                    max(pts[0].x, max(pts[1].x, pts[2].x)), max(pts[0].y, max(pts[1].y, pts[2].y)));
+}
+
+// Records a filled circle of the given diameter centred at (x, y). It covers
+// x - diameter / 2 - 1 to x + diameter / 2 + 1 (anti-aliased edge) and
+// y - diameter / 2 to y + diameter / 2.
+static void add_disc(int x, int y, int diameter, lv_opa_t opa, uint16_t color) {
+    frame_list_make_room();
+    display_list_disc(&frame_list, x, y, diameter / 2, color, opa);
 }
 
 // r4: Draws multiple small circles at random positions.
@@ -326,62 +533,66 @@ void draw_r3() {
 // The number of circles drawn per frame is controlled by `ws_number_value`.
 // The size (diameter) of the circles is scaled by `ws_slider_value` relative to the calculated cell size (derived from image dimensions).
 // Controlled by `draw_r4_enabled` flag, toggled by "r4 on" / "r4 off" commands.
-static void draw_r4()
+// The frame scheduler may grant fewer than the requested circles (iterations).
+static void draw_r4(const ImageFrame* img, int iterations)
 {
-    if (!canvas) return;
-    // Determine the number of iterations based on ws_number_value
-    int iterations = max(1, (int)ws_number_value);
-
-    for (int i = 0; i < iterations; ++i) {
-        // Pick a random point on the canvas
-        int x = random(0, CANVAS_WIDTH);
-        int y = random(0, CANVAS_HEIGHT);
-
-        // Determine grid dimensions based on decoded image
-        int grid_cols = decoded_img_width > 0 ? decoded_img_width : 1;
-        int grid_rows = decoded_img_height > 0 ? decoded_img_height : 1;
-
-        // Calculate cell size for mapping canvas coords to image cells
-        float cell_w = (float)CANVAS_WIDTH / grid_cols;
-        float cell_h = (float)CANVAS_HEIGHT / grid_rows;
-
-        // Sample color from image if available, otherwise pick palette
-        uint16_t pixel_color_raw;
-        if (decoded_img_buffer && decoded_img_width > 0 && decoded_img_height > 0) {
-            int c = constrain(x / cell_w, 0, decoded_img_width - 1);
-            int r = constrain(y / cell_h, 0, decoded_img_height - 1);
-            pixel_color_raw = decoded_img_buffer[r * decoded_img_width + c];
-        } else {
-            // Choose a random color from palette if no image
-            uint8_t idx = random(0, palette_size);
-            pixel_color_raw = palette[idx].full;
+    if (!canvas || !cbuf) return;
+
+    Rng* rng = &layer_rng[LAYER_R4];
+    uint16_t xs[R4_BATCH], ys[R4_BATCH];
+    for (int done = 0; done < iterations; done += R4_BATCH) {
+        // Random points on the canvas, a batch at a time
+        int batch = min(iterations - done, R4_BATCH);
+        rng_fill_below(rng, xs, batch, CANVAS_WIDTH);
+        rng_fill_below(rng, ys, batch, CANVAS_HEIGHT);
+
+        for (int i = 0; i < batch; ++i) {
+            int x = xs[i];
+            int y = ys[i];
+
+            // Determine grid dimensions based on decoded image
+            int grid_cols = img->width > 0 ? img->width : 1;
+            int grid_rows = img->height > 0 ? img->height : 1;
+
+            // Calculate cell size for mapping canvas coords to image cells
+            float cell_w = (float)CANVAS_WIDTH / grid_cols;
+            float cell_h = (float)CANVAS_HEIGHT / grid_rows;
+
+            // Sample color from image if available, otherwise pick palette
+            uint16_t pixel_color_raw;
+            if (img->pixels && img->width > 0 && img->height > 0) {
+                int c = constrain(x / cell_w, 0, img->width - 1);
+                int r = constrain(y / cell_h, 0, img->height - 1);
+                pixel_color_raw = img->pixels[r * img->width + c];
+            } else {
+                // Choose a random color from palette if no image
+                uint8_t idx = rng_below(rng, palette_size);
+                pixel_color_raw = palette[idx].full;
+            }
+            lv_color_t pixel_color;
+            pixel_color.full = pixel_color_raw;
+
+            // Determine circle size relative to cell size
+            float scale = constrain(ws_number_value, 0.1f, 1.5f);
+            float dia_f = fminf(cell_w, cell_h) * scale;
+            int dia = dia_f >= 1.0f ? (int)dia_f : 1;
+            int radius = ws_slider_value * dia / 2;
+
+            // Filled circle of diameter dia with its bounding box at (x - radius, y - radius)
+            add_disc(x - radius + dia / 2, y - radius + dia / 2, dia, (lv_opa_t)(ws_slider_value * 255), pixel_color.full);
+            dirty_rects_add(&frame_dirty, x - radius - 1, y - radius, x - radius + dia + 1, y - radius + dia);
         }
-        lv_color_t pixel_color;
-        pixel_color.full = pixel_color_raw;
-
-        // Determine circle size relative to cell size
-        float scale = constrain(ws_number_value, 0.1f, 1.5f);
-        float dia_f = fminf(cell_w, cell_h) * scale;
-        int dia = dia_f >= 1.0f ? (int)dia_f : 1;
-        int radius = ws_slider_value * dia / 2;
-
-        // Draw filled circle at (x,y)
-        lv_draw_rect_dsc_t dsc;
-        lv_draw_rect_dsc_init(&dsc);
-        dsc.radius = LV_RADIUS_CIRCLE;
-        // dsc.bg_opa = LV_OPA_COVER;
-        dsc.bg_opa = (lv_opa_t)(ws_slider_value * 255);
-        dsc.bg_color = pixel_color;
-        lv_canvas_draw_rect(canvas, x - radius, y - radius, dia, dia, &dsc);
     }
 }
 
 // r5: Pointillist effect. Draws a grid of circles representing the pixels of the decoded image.
-// The grid dimensions match the `decoded_img_width` and `decoded_img_height`.
-// The color of each circle is taken directly from the corresponding pixel in `decoded_img_buffer`.
+// The grid dimensions match the width and height of the published image.
+// The color of each circle is taken directly from the corresponding pixel of the image.
 // The relative size of the circles within their grid cells is controlled by `ws_number_value`.
 // Controlled by `draw_r5_enabled` flag, toggled by "r5 on" / "r5 off" commands.
-static void draw_r5() { // New signature, no event argument
+// Draws at most max_cells cells, continuing where the previous frame stopped, so
+// when the frame scheduler cuts the work the whole grid is refreshed over several frames.
+static int draw_r5(const ImageFrame* img, int max_cells) {
     // lv_obj_t *canvas = lv_event_get_target(e); // No longer get canvas from event
     // lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e); // No longer get draw_ctx from event
     // if (!draw_ctx) { // No longer needed
@@ -389,28 +600,28 @@ static void draw_r5() { // New signature, no event argument
     //     return;
     // }
 
-    if (!canvas) { // Check global canvas
+    if (!canvas || !cbuf) { // Check global canvas
         LV_LOG_ERROR("draw_r5: Global canvas is NULL.");
-        return;
+        return 0;
     }
 
-    if (!decoded_img_buffer || decoded_img_width <= 0 || decoded_img_height <= 0) {
+    if (!img->pixels || img->width <= 0 || img->height <= 0) {
         LV_LOG_WARN("draw_r5: Image buffer not available or invalid dimensions.");
         // Optionally, draw a placeholder or clear the canvas
         // lv_canvas_fill_bg(canvas, lv_color_hex(0xff0000), LV_OPA_COVER); // Example: fill red
-        return;
+        return 0;
     }
 
     lv_coord_t canvas_w = lv_obj_get_width(canvas);
     lv_coord_t canvas_h = lv_obj_get_height(canvas);
 
     // Grid dimensions are determined by the decoded image dimensions
-    int grid_cols = decoded_img_width;
-    int grid_rows = decoded_img_height;
+    int grid_cols = img->width;
+    int grid_rows = img->height;
 
     if (grid_cols <= 0 || grid_rows <= 0) {
         LV_LOG_WARN("draw_r5: Decoded image dimensions are invalid for grid.");
-        return;
+        return 0;
     }
 
     // Calculate cell size to fit the image grid onto the canvas
@@ -431,52 +642,168 @@ static void draw_r5() { // New signature, no event argument
     int circle_radius = circle_diameter / 2;
 
 
-    lv_draw_rect_dsc_t rect_dsc;
-    lv_draw_rect_dsc_init(&rect_dsc);
-    rect_dsc.radius = LV_RADIUS_CIRCLE; // Make it a circle
-    // rect_dsc.border_width = 1; // Optional: border for circles
-    // rect_dsc.border_color = lv_color_black();
-    // rect_dsc.border_opa = LV_OPA_50;
-    rect_dsc.bg_opa = LV_OPA_COVER;     // Make the circle filled
-
-    for (int r = 0; r < grid_rows; ++r) { // row in the display grid (maps to src_y)
-        for (int c = 0; c < grid_cols; ++c) { // column in the display grid (maps to src_x)
-            
-            // Source pixel from the image buffer
-            // (r, c) directly map to (src_y, src_x) because grid dimensions = image dimensions
-            uint16_t pixel_color_raw = decoded_img_buffer[r * decoded_img_width + c];
-            lv_color_t pixel_color;
-            pixel_color.full = pixel_color_raw; // Assuming LV_COLOR_DEPTH 16 (RGB565)
+    int cells = grid_cols * grid_rows;
+    int count = min(max_cells, cells);
+    int first = r5_next_cell < cells ? r5_next_cell : 0;
+    int r = first / grid_cols; // row in the display grid (maps to src_y)
+    int c = first % grid_cols; // column in the display grid (maps to src_x)
+    for (int k = 0; k < count; ++k) {
+        // Source pixel from the image buffer
+        // (r, c) directly map to (src_y, src_x) because grid dimensions = image dimensions
+        uint16_t pixel_color_raw = img->pixels[r * img->width + c]; // RGB565, like cbuf
 
-            rect_dsc.bg_color = pixel_color;
+        // Calculate circle position (center of the cell on the canvas)
+        lv_coord_t center_x = (lv_coord_t)((c + 0.5f) * cell_w);
+        lv_coord_t center_y = (lv_coord_t)((r + 0.5f) * cell_h);
 
-            // Calculate circle position (center of the cell on the canvas)
-            lv_coord_t center_x = (lv_coord_t)((c + 0.5f) * cell_w);
-            lv_coord_t center_y = (lv_coord_t)((r + 0.5f) * cell_h);
+        add_disc(center_x - circle_radius + circle_diameter / 2, center_y - circle_radius + circle_diameter / 2,
+                 circle_diameter, LV_OPA_COVER, pixel_color_raw);
 
-            lv_canvas_draw_rect(canvas, center_x - circle_radius, center_y - circle_radius, circle_diameter, circle_diameter, &rect_dsc);
+        if (++c == grid_cols) {
+            c = 0;
+            if (++r == grid_rows) r = 0;
         }
     }
+    r5_next_cell = (first + count) % cells;
+
+    // The drawn cells span from the first to the last drawn row (all rows if the grid wrapped)
+    int first_row = first / grid_cols;
+    int last_row = (first + count - 1) / grid_cols;
+    if (last_row >= grid_rows) {
+        first_row = 0;
+        last_row = grid_rows - 1;
+    }
+    dirty_rects_add(&frame_dirty, (int)(0.5f * cell_w) - circle_radius - 1,
+                    (int)((first_row + 0.5f) * cell_h) - circle_radius,
+                    (int)((grid_cols - 0.5f) * cell_w) - circle_radius + circle_diameter + 1,
+                    (int)((last_row + 0.5f) * cell_h) - circle_radius + circle_diameter);
+    return count;
+}
+
+// Invalidates the merged areas the layers drew into this frame
+static void invalidate_frame_dirty() {
+    lv_area_t canvas_coords;
+    lv_obj_get_coords(canvas, &canvas_coords);
+    for (int i = 0; i < frame_dirty.count; ++i) {
+        const DirtyRect& r = frame_dirty.rects[i];
+        lv_area_t area;
+        area.x1 = canvas_coords.x1 + r.x1;
+        area.y1 = canvas_coords.y1 + r.y1;
+        area.x2 = canvas_coords.x1 + r.x2;
+        area.y2 = canvas_coords.y1 + r.y2;
+        lv_obj_invalidate_area(canvas, &area);
+    }
 }
 
 static void draw_frame(lv_timer_t *t)
 {
+  stage_timer_end_frame(); // The previous frame's record ends with its refresh and flush
   process_text_commands(); // Process text commands once per frame
 
-  check_image_update(); // Handle background image update (r0)
+  // Pin the current image for the whole frame; the network task decodes into the other buffer
+  const ImageFrame* img = image_buffer_acquire();
+  image_buffer_mark_presented(img); // Acknowledged to the sender for frame pacing
+
+  int requested[LAYER_COUNT] = { 0 };
+  // r0 costs a redraw only when a new image is pending; otherwise it leaves its budget to the others
+  requested[LAYER_R0] = draw_r0_enabled && img->pixels && img->seq != r0_drawn_seq ? 1 : 0;
+  requested[LAYER_R1] = draw_r1_enabled ? 1 : 0;
+  requested[LAYER_R2] = draw_r2_enabled ? 1 : 0;
+  requested[LAYER_R3] = draw_r3_enabled ? 1 : 0;
+  requested[LAYER_R4] = draw_r4_enabled ? max(1, (int)ws_number_value) : 0;
+  requested[LAYER_R5] = draw_r5_enabled ? max(1, img->width * img->height) : 0; // r5's grid is the decoded image
+  frame_scheduler_plan(&frame_sched, requested);
+
+  uint32_t start = stage_cycles();
+  // r0 only redraws when a new image was published; a frame without one is not a measurement
+  if (check_image_update(img)) {
+    uint32_t cycles = stage_cycles() - start;
+    stage_add(STAGE_R0, cycles);
+    frame_scheduler_measure(&frame_sched, LAYER_R0, 1, stage_cycles_to_us(cycles));
+  }
 
   if (!draw_r0_enabled && !draw_r1_enabled && !draw_r2_enabled && !draw_r3_enabled && !draw_r4_enabled && !draw_r5_enabled) {
     // If all drawing is disabled, maybe ensure canvas is clear or shows a default state
     // For now, this is handled by "clear" command and when r0 is turned off.
   }
-  
-  if (draw_r1_enabled) draw_r1();
-  if (draw_r2_enabled) draw_r2();
-  if (draw_r3_enabled) draw_r3();
-  if (draw_r4_enabled) draw_r4();
-  if (draw_r5_enabled) draw_r5(); 
+
+  // The layers record into frame_list and collect the areas they touch. Each
+  // layer is flushed on its own so its measured time includes the rasterization.
+  dirty_rects_reset(&frame_dirty, CANVAS_WIDTH, CANVAS_HEIGHT);
+  for (int layer = LAYER_R1; layer < LAYER_COUNT; ++layer) {
+    const FrameLayer& l = frame_sched.layers[layer];
+    if (l.requested == 0) continue;
+    start = stage_cycles();
+    int units = 1;
+    switch (layer) {
+      case LAYER_R1: draw_r1(); break;
+      case LAYER_R2: draw_r2(); break;
+      case LAYER_R3: draw_r3(); break;
+      case LAYER_R4: draw_r4(img, l.granted); units = l.granted; break;
+      case LAYER_R5: units = draw_r5(img, l.granted); break;
+    }
+    flush_frame_list();
+    uint32_t cycles = stage_cycles() - start;
+    stage_add((Stage)(STAGE_R0 + layer), cycles);
+    frame_scheduler_measure(&frame_sched, layer, units, stage_cycles_to_us(cycles));
+  }
+  frame_scheduler_end_frame(&frame_sched);
+  image_buffer_release(img);
+  if (canvas) invalidate_frame_dirty();
+
+  if (millis() - sched_report_ms >= SCHED_REPORT_PERIOD) {
+    sched_report_ms = millis();
+    static SketchReport report; // Too large for the LVGL task's stack
+    if (frame_scheduler_format(&frame_sched, layer_names, frame_period_ms, report.json, sizeof(report.json))) {
+      report_queue.push(report); // Dropped if the network task has not sent the previous ones yet
+    }
+    if (stage_timer_format(report.json, sizeof(report.json))) report_queue.push(report);
+  }
+}
+
+// Draws one layer on its own, the way draw_frame does but regardless of its toggle
+// and the frame scheduler. For benchmarks; r0 only redraws when a new image was published.
+int32_t sketch_draw_layer(int layer) {
+  if (!canvas || !cbuf) return 0;
+  dirty_rects_reset(&frame_dirty, CANVAS_WIDTH, CANVAS_HEIGHT);
+  int32_t pixels = 0;
+  if (layer == LAYER_R0) {
+    const ImageFrame* img = image_buffer_acquire();
+    bool redraw = img->seq != r0_drawn_seq;
+    if (redraw && img->width > 0 && img->height > 0) {
+      float scale = fminf((float)CANVAS_WIDTH / img->width, (float)CANVAS_HEIGHT / img->height);
+      pixels = (int32_t)(img->width * scale) * (int32_t)(img->height * scale);
+    }
+    bool enabled = draw_r0_enabled;
+    draw_r0_enabled = true;
+    check_image_update(img);
+    draw_r0_enabled = enabled;
+    image_buffer_release(img);
+    return pixels;
+  }
+
+  const ImageFrame* img = image_buffer_acquire();
+  switch (layer) {
+    case LAYER_R1: draw_r1(); break;
+    case LAYER_R2: draw_r2(); break;
+    case LAYER_R3: draw_r3(); break;
+    case LAYER_R4: draw_r4(img, max(1, (int)ws_number_value)); break;
+    case LAYER_R5: draw_r5(img, INT_MAX); break;
+  }
+  flush_frame_list();
+  image_buffer_release(img);
+  return dirty_rects_area(&frame_dirty);
+}
+
+// Called from the network task
+bool sketch_pop_report(char* buf, size_t cap) {
+  static SketchReport report;
+  if (!report_queue.pop(report)) return false;
+  strlcpy(buf, report.json, cap);
+  return true;
 }
 
+
 /////////
 
 // Event callback for screen taps
@@ -533,7 +860,7 @@ static void screen_event_cb(lv_event_t * e) {
 void sketch_setup()
 {
   // Allocate canvas in PSRAM
-  cbuf = (lv_color_t *)heap_caps_malloc(
+  cbuf = (lv_color_t *)heap_tag_malloc(HEAP_TAG_CANVAS,
       LV_CANVAS_BUF_SIZE_TRUE_COLOR(CANVAS_WIDTH, CANVAS_HEIGHT),
       MALLOC_CAP_SPIRAM);
 
@@ -554,6 +881,15 @@ void sketch_setup()
   // --- End touch setup ---
 
 
+  // Display list arena: internal RAM if there is room, it is read once per tile on replay
+  void* frame_list_arena = heap_tag_malloc(HEAP_TAG_CANVAS, FRAME_LIST_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!frame_list_arena) frame_list_arena = heap_tag_malloc(HEAP_TAG_CANVAS, FRAME_LIST_BYTES, MALLOC_CAP_SPIRAM);
+  if (!frame_list_arena) Serial.println("❌ Failed to allocate the display list arena");
+  display_list_init(&frame_list, frame_list_arena, frame_list_arena ? FRAME_LIST_BYTES : 0);
+
+  // Second core for rasterizing the canvas; without it everything is drawn on this core
+  if (!render_jobs_init()) Serial.println("❌ Failed to start the render worker task");
+
   // Create the canvas if buffer allocation succeeded
   if (cbuf) {
       canvas = lv_canvas_create(scr);
@@ -572,9 +908,16 @@ void sketch_setup()
   }
 
 
+  // Different pictures on every boot (random() is the hardware RNG on the ESP32); "seed <n>" repeats them
+  sketch_seed((uint32_t)random(0x7FFFFFFF));
+
   // Set a timer to draw generatively like a sketch loop
   Serial.println("Creating draw_frame timer..."); // DEBUG
-  lv_timer_create(draw_frame, UPDATE_PERIOD, NULL);
+  frame_scheduler_init(&frame_sched, LAYER_COUNT, 0);
+  frame_scheduler_set_scalable(&frame_sched, LAYER_R4, true);
+  frame_scheduler_set_scalable(&frame_sched, LAYER_R5, true);
+  frame_timer = lv_timer_create(draw_frame, frame_period_ms, NULL);
+  set_frame_period(frame_period_ms);
   Serial.println("draw_frame timer created."); // DEBUG
 
 
@@ -609,7 +952,7 @@ void sketch_setup()
 void sketch_loop()
 {
   // --- Message parsing for text commands ---
-  check_image_update(); // Check for new image updates
+  // The image background (r0) is drawn by draw_frame, where it is timed with the other layers
 
   // Parse text commands for toggling draw algorithms and clear
   if (strcmp(ws_text_value, "clear") == 0) {
@@ -701,8 +1044,11 @@ void lvgl_event_cb(lv_event_t *e) {
         if (draw_r1_enabled) draw_r1(); // Call without event argument
         if (draw_r2_enabled) draw_r2(); // Call without event argument
         if (draw_r3_enabled) draw_r3(); // Call without event argument
-        if (draw_r4_enabled) draw_r4(); // Call without event argument
-        if (draw_r5_enabled) draw_r5(); // Corrected: Call without event argument
+        const ImageFrame* img = image_buffer_acquire();
+        if (draw_r4_enabled) draw_r4(img, max(1, (int)ws_number_value)); // Call without event argument
+        if (draw_r5_enabled) draw_r5(img, INT_MAX); // Corrected: Call without event argument
+        flush_frame_list();
+        image_buffer_release(img);
     }
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lvgl.h>
+#include <stddef.h>
 
 // Declare the IP address string as extern so sketch.cpp can access it
 extern char ip_address_str[16];
@@ -9,8 +10,6 @@ extern char ip_address_str[16];
 extern float ws_slider_value;
 extern float ws_number_value;
 extern char ws_text_value[1024]; // Increased for longer commands
-extern int decoded_img_width;
-extern int decoded_img_height;
 
 void sketch_setup();  // to be called from setup
 void sketch_loop();   // optional: if you want animation or interaction
@@ -21,15 +20,33 @@ void sketch_loop();   // optional: if you want animation or interaction
 // extern lv_obj_t *canvas; // canvas is static in sketch.cpp
 // extern lv_color_t *cbuf; // cbuf is static in sketch.cpp
 
-extern uint16_t* decoded_img_buffer; // Corrected to uint16_t*
-extern int decoded_img_width;
-extern int decoded_img_height;
-extern size_t decoded_img_size; // Added this line
-extern volatile bool new_image_available; 
+// The decoded image is shared with the network task through image_buffer.h
 
 // Add extern declarations for the dimensions received from WebSocket
 extern int received_image_width;
 extern int received_image_height;
 
+// Smallest image size the enabled layers can make use of. Safe to call from the
+// network task; the decoder uses it to pick a JPEG scale (1/2, 1/4, 1/8).
+void sketch_get_image_target(int* width, int* height);
+
+// Drawing layers, in the order draw_frame draws them
+enum SketchLayer { LAYER_R0, LAYER_R1, LAYER_R2, LAYER_R3, LAYER_R4, LAYER_R5, LAYER_COUNT };
+
+// For benchmarks (host/sketch_bench.cpp): draws one layer into the canvas on the
+// current image, whether or not it is enabled and without the frame scheduler's
+// limits. r0 only draws when a new image has been published since its last call.
+// Returns the canvas pixels the layer marked dirty. Call from the LVGL task.
+int32_t sketch_draw_layer(int layer);
+
+// Reseeds the layers' random streams (layer_rng.h); a seed repeats the
+// pictures. Call from the LVGL task.
+void sketch_seed(uint32_t seed);
+
+// Messages the sketch wants sent over the WebSocket (e.g. the {"type":"sched"}
+// report). Called from the network task; returns false when there are none.
+#define SKETCH_REPORT_MAX 1024
+bool sketch_pop_report(char* buf, size_t cap);
+
 void sketch_setup();  // to be called from setup
 void sketch_loop();   // optional: if you want animation or interaction
\ No newline at end of file
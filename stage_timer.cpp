@@ -0,0 +1,84 @@
+#include "stage_timer.h"
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#if defined(ESP_PLATFORM)
+#include "esp_rom_sys.h"
+#else
+#include <chrono>
+#endif
+
+static const char* const stage_names[STAGE_COUNT] = { "json", "base64", "jpeg", "r0",   "r1",   "r2",
+                                                      "r3",   "r4",     "r5",   "lvgl", "flush" };
+
+struct StageFrame {
+    uint32_t cycles[STAGE_COUNT];
+};
+
+static std::atomic<uint32_t> current[STAGE_COUNT]; // Frame being measured; the network task adds to it too
+static StageFrame ring[STAGE_RING_FRAMES];
+static uint32_t ring_head = 0;     // Next record to write
+static uint32_t window_frames = 0; // Frames ended since the last stage_timer_format
+
+#if defined(ESP_PLATFORM)
+uint32_t stage_cycles_to_us(uint32_t cycles) {
+    return cycles / esp_rom_get_cpu_ticks_per_us();
+}
+#else
+uint32_t stage_cycles() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t stage_cycles_to_us(uint32_t cycles) {
+    return cycles / 1000;
+}
+#endif
+
+void stage_add(Stage stage, uint32_t cycles) {
+    current[stage].fetch_add(cycles, std::memory_order_relaxed);
+}
+
+void stage_timer_end_frame() {
+    StageFrame& f = ring[ring_head];
+    for (int i = 0; i < STAGE_COUNT; ++i) f.cycles[i] = current[i].exchange(0, std::memory_order_relaxed);
+    ring_head = (ring_head + 1) % STAGE_RING_FRAMES;
+    window_frames++;
+}
+
+size_t stage_timer_format(char* buf, size_t cap) {
+    uint32_t frames = window_frames < STAGE_RING_FRAMES ? window_frames : STAGE_RING_FRAMES;
+    int n = snprintf(buf, cap, "{\"type\":\"stats\",\"frames\":%u,\"stages\":[", (unsigned)window_frames);
+    if (n < 0 || (size_t)n >= cap) return 0;
+    size_t len = n;
+    window_frames = 0;
+
+    bool first = true;
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        // Frames of the window in which the stage ran, oldest first
+        uint32_t values[STAGE_RING_FRAMES];
+        uint32_t count = 0;
+        uint64_t sum = 0;
+        for (uint32_t k = 0; k < frames; ++k) {
+            uint32_t c = ring[(ring_head + STAGE_RING_FRAMES - frames + k) % STAGE_RING_FRAMES].cycles[s];
+            if (c == 0) continue;
+            values[count++] = c;
+            sum += c;
+        }
+        if (count == 0) continue;
+        std::sort(values, values + count);
+        uint32_t p95 = values[(count * 95 + 99) / 100 - 1];
+        n = snprintf(buf + len, cap - len, "%s{\"name\":\"%s\",\"n\":%u,\"min\":%u,\"mean\":%u,\"p95\":%u,\"max\":%u}",
+                     first ? "" : ",", stage_names[s], (unsigned)count, (unsigned)stage_cycles_to_us(values[0]),
+                     (unsigned)stage_cycles_to_us((uint32_t)(sum / count)), (unsigned)stage_cycles_to_us(p95),
+                     (unsigned)stage_cycles_to_us(values[count - 1]));
+        if (n < 0 || (size_t)n >= cap - len) return 0;
+        len += n;
+        first = false;
+    }
+    if (cap - len < 3) return 0;
+    buf[len++] = ']';
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Cycle-counter timers for the stages a frame goes through, from the network
+// task (JSON, base64, JPEG) to the render loop (each layer, lv_timer_handler,
+// the display flush).
+//
+// A StageScope reads the CPU cycle counter when it is created and adds the
+// cycles to its stage when it goes out of scope. Each stage accumulates into
+// the current frame's record; stage_timer_end_frame() moves the record into a
+// ring of the last STAGE_RING_FRAMES frames. stage_timer_format() summarizes
+// the frames since its previous call as a {"type":"stats"} message: min, mean,
+// 95th percentile and max per stage, in microseconds, over the frames in which
+// the stage ran. Stages nest (lvgl includes the layers and the flush).
+//
+// The cycle counter is per core, so a scope must start and end on the same
+// core; the network task and the render loop are both pinned. Build with
+// STAGE_TIMERS=0 to compile the scopes out.
+
+#ifndef STAGE_TIMERS
+#define STAGE_TIMERS 1
+#endif
+
+#define STAGE_RING_FRAMES 128 // Frames kept for the statistics, about 2 s at 60 fps
+
+enum Stage {
+    STAGE_JSON,   // ws_control_parse / deserializeJson
+    STAGE_BASE64, // base64 image payloads
+    STAGE_JPEG,   // JPEG decode into the image buffer
+    STAGE_R0,     // r0-r5: each draw layer, including its rasterization
+    STAGE_R1,
+    STAGE_R2,
+    STAGE_R3,
+    STAGE_R4,
+    STAGE_R5,
+    STAGE_LVGL,   // lv_timer_handler
+    STAGE_FLUSH,  // Lvgl_Display_LCD
+    STAGE_COUNT
+};
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+static inline uint32_t stage_cycles() {
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+#else
+uint32_t stage_cycles(); // Nanoseconds of the host's steady clock
+#endif
+
+// Converts a cycle count (a difference of stage_cycles() values) to microseconds.
+uint32_t stage_cycles_to_us(uint32_t cycles);
+
+// Adds cycles to a stage of the current frame. Any task.
+void stage_add(Stage stage, uint32_t cycles);
+
+// Closes the current frame's record. Render loop only.
+void stage_timer_end_frame();
+
+// Writes the {"type":"stats"} summary of the frames since the previous call
+// and starts a new window. Returns the length, or 0 if buf is too small.
+// Render loop only.
+size_t stage_timer_format(char* buf, size_t cap);
+
+class StageScope {
+public:
+#if STAGE_TIMERS
+    explicit StageScope(Stage stage) : stage_(stage), start_(stage_cycles()) {}
+    ~StageScope() { stage_add(stage_, stage_cycles() - start_); }
+
+private:
+    Stage stage_;
+    uint32_t start_;
+#else
+    explicit StageScope(Stage stage) { (void)stage; }
+#endif
+};
@@ -0,0 +1,140 @@
+// Host benchmark for the block base64 decoder (base64_utils.cpp) against the
+// previous byte-at-a-time decoder, on 50 KB - 2 MB payloads. Also checks that
+// both produce identical output and that invalid input is rejected.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. -Ihost tests/bench_base64.cpp base64_utils.cpp psram_pool.cpp heap_stats.cpp -o bench_base64
+//   ./bench_base64
+
+#include "base64_utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// --- Previous implementation, kept as the reference ---
+static const int8_t ref_table[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
+    52,53,54,55,56,57,58,59,60,61,-1,-1,-1, 0,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
+    15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
+    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
+    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+static int ref_base64_decode(const char* input, uint8_t* output, size_t output_len) {
+    size_t in_len = 0;
+    while (input[in_len] && input[in_len] != '=') in_len++;
+    size_t out_idx = 0;
+    int val = 0, valb = -8;
+    for (size_t i = 0; input[i] && input[i] != '='; ++i) {
+        int8_t c = ref_table[(uint8_t)input[i]];
+        if (c == -1) continue;
+        val = (val << 6) + c;
+        valb += 6;
+        if (valb >= 0) {
+            if (out_idx >= output_len) return -1;
+            output[out_idx++] = (uint8_t)((val >> valb) & 0xFF);
+            valb -= 8;
+        }
+    }
+    return (int)out_idx;
+}
+// --- End reference ---
+
+static std::string encode(const std::vector<uint8_t>& data) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out += alphabet[v >> 18]; out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63]; out += alphabet[v & 63];
+    }
+    if (i < data.size()) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < data.size()) v |= data[i + 1] << 8;
+        out += alphabet[v >> 18]; out += alphabet[(v >> 12) & 63];
+        out += (i + 1 < data.size()) ? alphabet[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+template <typename F>
+static double time_mbps(F fn, size_t input_bytes) {
+    using clock = std::chrono::steady_clock;
+    int reps = 0;
+    auto start = clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        reps++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < 0.25);
+    return (double)input_bytes * reps / elapsed / (1024.0 * 1024.0);
+}
+
+static int check_edge_cases() {
+    uint8_t out[16];
+    int failures = 0;
+    struct { const char* in; int expect; } cases[] = {
+        { "", 0 }, { "TQ==", 1 }, { "TWE=", 2 }, { "TWFu", 3 }, { "TQ", 1 }, { "TWE", 2 },
+        { "T", -1 }, { "TW=u", -1 }, { "TWF\n", -1 }, { "TQ=", -1 }, { "====", -1 }, { "TWFu TWFu", -1 },
+    };
+    for (auto& c : cases) {
+        int got = base64_decode(c.in, out, sizeof(out));
+        if (got != c.expect) {
+            printf("edge case \"%s\": expected %d, got %d\n", c.in, c.expect, got);
+            failures++;
+        }
+    }
+    if (base64_decode("TWFu", out, 2) != -1) { printf("output bound not enforced\n"); failures++; }
+    return failures;
+}
+
+int main() {
+    int failures = check_edge_cases();
+    const size_t sizes[] = { 50 * 1024, 200 * 1024, 500 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+
+    printf("%-10s %12s %12s %8s\n", "payload", "old MB/s", "new MB/s", "speedup");
+    srand(1);
+    for (size_t size : sizes) {
+        for (size_t extra = 0; extra < 3; ++extra) { // cover all three padding cases
+            std::vector<uint8_t> data(size + extra);
+            for (auto& b : data) b = (uint8_t)rand();
+            std::string b64 = encode(data);
+            std::vector<uint8_t> a(data.size()), b(data.size());
+
+            int na = ref_base64_decode(b64.c_str(), a.data(), a.size());
+            int nb = base64_decode(b64.c_str(), b.data(), b.size());
+            size_t exact = base64_decoded_size(b64.c_str(), b64.size());
+            if (na != (int)data.size() || nb != na || exact != data.size() || memcmp(a.data(), data.data(), data.size()) != 0 ||
+                memcmp(b.data(), data.data(), data.size()) != 0) {
+                printf("mismatch at %zu bytes\n", data.size());
+                failures++;
+                continue;
+            }
+            if (extra) continue;
+
+            double old_mbps = time_mbps([&] { ref_base64_decode(b64.c_str(), a.data(), a.size()); }, b64.size());
+            double new_mbps = time_mbps([&] { base64_decode_n(b64.c_str(), b64.size(), b.data(), b.size()); }, b64.size());
+            printf("%7zu KB %12.1f %12.1f %7.2fx\n", size / 1024, old_mbps, new_mbps, new_mbps / old_mbps);
+        }
+    }
+    if (failures) printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// Host benchmark for the allocation-free control message parser (ws_control.cpp).
+// Reports messages per second and heap allocations per message.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. tests/bench_ws_control.cpp ws_control.cpp -o bench_ws_control
+//   ./bench_ws_control
+
+#include "ws_control.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// --- Allocation counting ---
+static size_t g_alloc_count = 0;
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void *malloc(size_t n) { ++g_alloc_count; return __libc_malloc(n); }
+extern "C" void *calloc(size_t n, size_t s) { ++g_alloc_count; return __libc_calloc(n, s); }
+extern "C" void *realloc(void *p, size_t n) { ++g_alloc_count; return __libc_realloc(p, n); }
+#endif
+
+void *operator new(size_t n) {
+    ++g_alloc_count;
+    void *p = std::malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+// --- End allocation counting ---
+
+static const char *messages[] = {
+    "{\"type\":\"slider\",\"value\":0.4}",
+    "{\"type\":\"slider\",\"value\":0.41}",
+    "{\"type\":\"number\",\"value\":12}",
+    "{ \"type\": \"text\", \"value\": \"r2 on\" }",
+    "{\"value\":0.73,\"type\":\"slider\"}",
+    "{\"type\":\"text\",\"value\":\"line \\\"quoted\\\"\\n\\u00e9\"}",
+};
+static const int message_count = sizeof(messages) / sizeof(messages[0]);
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    static char text[1024];
+    size_t lens[message_count];
+    for (int i = 0; i < message_count; ++i) lens[i] = strlen(messages[i]);
+
+    // Sanity check before timing
+    WsControlMsg msg;
+    if (!ws_control_parse(messages[0], lens[0], &msg, text, sizeof(text)) || msg.type != WS_CONTROL_SLIDER || msg.value != 0.4f) {
+        printf("parse check failed\n");
+        return 1;
+    }
+    if (ws_control_parse("{\"type\":\"image\",\"data\":\"AAAA\"}", 30, &msg, text, sizeof(text))) {
+        printf("image message should not take the fast path\n");
+        return 1;
+    }
+
+    using clock = std::chrono::steady_clock;
+    size_t parsed = 0, failed = 0;
+    float sink = 0.0f;
+    size_t allocs_before = g_alloc_count;
+    auto start = clock::now();
+    auto deadline = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+    while (clock::now() < deadline) {
+        for (int rep = 0; rep < 1000; ++rep) {
+            int i = (int)(parsed % message_count);
+            if (ws_control_parse(messages[i], lens[i], &msg, text, sizeof(text))) {
+                sink += msg.value + (float)msg.text_len;
+            } else {
+                failed++;
+            }
+            parsed++;
+        }
+    }
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    size_t allocs = g_alloc_count - allocs_before;
+
+    printf("messages:          %zu (%zu failed)\n", parsed, failed);
+    printf("messages/s:        %.0f\n", parsed / elapsed);
+    printf("ns/message:        %.1f\n", elapsed * 1e9 / parsed);
+    printf("allocations/msg:   %.6f\n", (double)allocs / parsed);
+    printf("(checksum %.1f)\n", sink);
+    return (failed == 0 && allocs == 0) ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// Host test for the display list (display_list.cpp): random lines, arcs,
+// triangles and discs are recorded and replayed, and the result is compared
+// with a reference that evaluates each primitive's coverage at every pixel of
+// its bounding box, one primitive at a time over the whole canvas. Covers the
+// binned tile replay, the fallback when the bins overflow, replay in bands
+// with display_list_replay_rect, and a full arena. Also prints the replay
+// time against drawing the same list without tiling.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. tests/test_display_list.cpp display_list.cpp disc_splat.cpp rgb565_blend.cpp -o test_display_list
+//   ./test_display_list
+
+#include "display_list.h"
+#include "disc_splat.h"
+#include "rgb565_blend.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define CANVAS 480
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// --- Reference: every pixel of the bounding box, straight from the coverage model ---
+static uint8_t ref_coverage(float c) {
+    if (c <= 0.0f) return 0;
+    if (c >= 1.0f) return 255;
+    return (uint8_t)(c * 255.0f + 0.5f);
+}
+
+static void ref_pixel(uint16_t* dst, int x, int y, const DlHeader* h, uint8_t cov) {
+    uint32_t a = (h->opa * cov + 1024u) >> 11;
+    uint16_t* p = &dst[y * CANVAS + x];
+    if (a >= 32) *p = h->color;
+    else if (a > 0) *p = rgb565_blend_pixel(*p, h->color, a);
+}
+
+static float ref_line(const DlLine* l, int x, int y) {
+    float dx = (float)(l->bx - l->ax), dy = (float)(l->by - l->ay);
+    float len2 = dx * dx + dy * dy;
+    float inv_len2 = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+    float px = x - (float)l->ax, py = y - (float)l->ay;
+    float t = fminf(fmaxf((px * dx + py * dy) * inv_len2, 0.0f), 1.0f);
+    float ex = px - t * dx, ey = py - t * dy;
+    return l->width * 0.5f + 0.5f - sqrtf(ex * ex + ey * ey);
+}
+
+static float ref_arc(const DlArc* a, int x, int y) {
+    float px = (float)(x - a->cx), py = (float)(y - a->cy);
+    float d = sqrtf(px * px + py * py);
+    float c = fminf(a->radius + 0.5f - d, d - (a->radius - a->width + 0.5f));
+    int span = a->end_angle - a->start_angle;
+    if (span < 360) {
+        float sa = a->start_angle * (3.14159265f / 180.0f), ea = a->end_angle * (3.14159265f / 180.0f);
+        float s1 = cosf(sa) * py - sinf(sa) * px;
+        float s2 = px * sinf(ea) - py * cosf(ea);
+        c = fminf(c, span <= 180 ? fminf(s1, s2) : fmaxf(s1, s2));
+    }
+    return c + 0.5f;
+}
+
+static float ref_triangle(const DlTriangle* t, int x, int y) {
+    int area = (t->x[1] - t->x[0]) * (t->y[2] - t->y[0]) - (t->x[2] - t->x[0]) * (t->y[1] - t->y[0]);
+    float d = 1e30f;
+    for (int i = 0; i < 3; ++i) {
+        int j = i == 2 ? 0 : i + 1;
+        float ex = (float)(t->x[j] - t->x[i]), ey = (float)(t->y[j] - t->y[i]);
+        float s = (area > 0 ? 1.0f : -1.0f) / sqrtf(ex * ex + ey * ey);
+        float nx = -ey * s, ny = ex * s;
+        float c = -(nx * t->x[i] + ny * t->y[i]);
+        d = fminf(d, nx * x + (ny * y + c));
+    }
+    return d + 0.5f;
+}
+
+static void ref_draw(uint16_t* dst, const DisplayList* list) {
+    for (size_t off = 0; off < list->used;) {
+        const DlHeader* h = (const DlHeader*)(list->arena + off);
+        off += h->size;
+        if (h->type == DL_DISC) {
+            const DlDisc* d = (const DlDisc*)h;
+            DiscSplat s = { d->x, d->y, (uint8_t)d->radius, h->opa, h->color };
+            disc_splat_draw(dst, CANVAS, 0, 0, CANVAS - 1, CANVAS - 1, &s, 1);
+            continue;
+        }
+        for (int y = h->y1 < 0 ? 0 : h->y1; y <= h->y2 && y < CANVAS; ++y) {
+            for (int x = h->x1 < 0 ? 0 : h->x1; x <= h->x2 && x < CANVAS; ++x) {
+                float c = h->type == DL_LINE ? ref_line((const DlLine*)h, x, y)
+                          : h->type == DL_ARC ? ref_arc((const DlArc*)h, x, y)
+                                              : ref_triangle((const DlTriangle*)h, x, y);
+                ref_pixel(dst, x, y, h, ref_coverage(c));
+            }
+        }
+    }
+}
+// --- End reference ---
+
+static int rnd(int lo, int hi) {
+    return lo + rand() % (hi - lo + 1);
+}
+
+// Records count random primitives of every type, some reaching past the canvas edges
+static void record_random(DisplayList* list, int count) {
+    for (int i = 0; i < count; ++i) {
+        uint16_t color = (uint16_t)rand();
+        uint8_t opa = (uint8_t)(rand() % 4 == 0 ? 255 : rand() % 256);
+        switch (rand() % 4) {
+        case 0:
+            display_list_line(list, rnd(-40, 520), rnd(-40, 520), rnd(-40, 520), rnd(-40, 520), rnd(1, 40), color, opa);
+            break;
+        case 1: {
+            int start = rnd(-360, 360);
+            display_list_arc(list, rnd(0, 480), rnd(0, 480), rnd(1, 160), rnd(1, 60), start, start + rnd(-400, 400),
+                             color, opa);
+            break;
+        }
+        case 2:
+            display_list_triangle(list, rnd(-40, 520), rnd(-40, 520), rnd(-40, 520), rnd(-40, 520), rnd(-40, 520),
+                                  rnd(-40, 520), color, opa);
+            break;
+        default:
+            display_list_disc(list, rnd(-10, 490), rnd(-10, 490), rnd(0, 30), color, opa);
+            break;
+        }
+    }
+}
+
+static std::vector<uint16_t> background() {
+    std::vector<uint16_t> canvas(CANVAS * CANVAS);
+    for (size_t i = 0; i < canvas.size(); ++i) canvas[i] = (uint16_t)(i * 2654435761u >> 7);
+    return canvas;
+}
+
+static int mismatches(const std::vector<uint16_t>& a, const std::vector<uint16_t>& b) {
+    int bad = 0;
+    for (size_t i = 0; i < a.size(); ++i) bad += a[i] != b[i];
+    return bad;
+}
+
+static void test_replay(int count) {
+    std::vector<uint32_t> arena(64 * 1024);
+    DisplayList list;
+    display_list_init(&list, arena.data(), arena.size() * 4);
+    record_random(&list, count);
+
+    auto ref = background();
+    ref_draw(ref.data(), &list);
+
+    auto tiled = background();
+    display_list_replay(&list, tiled.data(), CANVAS, CANVAS, CANVAS);
+    int bad = mismatches(tiled, ref);
+    printf("%5d records: %d mismatching pixels (tiled)\n", count, bad);
+    check(bad == 0, "tiled replay matches the reference");
+
+    // Bands of uneven height, as a split across cores would use
+    auto banded = background();
+    for (int y = 0; y < CANVAS; y += 37)
+        display_list_replay_rect(&list, banded.data(), CANVAS, 0, y, CANVAS - 1, y + 36 < CANVAS ? y + 36 : CANVAS - 1);
+    check(mismatches(banded, ref) == 0, "banded replay matches the reference");
+}
+
+static void test_arena_full() {
+    uint32_t arena[12]; // 48 bytes: two 20-byte discs
+    DisplayList list;
+    display_list_init(&list, arena, sizeof(arena));
+    check(display_list_disc(&list, 10, 10, 3, 0xFFFF, 255), "first disc fits");
+    check(display_list_disc(&list, 20, 10, 3, 0xFFFF, 255), "second disc fits");
+    check(!display_list_disc(&list, 30, 10, 3, 0xFFFF, 255), "third disc is refused");
+    check(list.count == 2, "refused disc is not recorded");
+    check(display_list_disc(&list, 30, 10, 3, 0xFFFF, 0), "invisible disc is accepted");
+    check(list.count == 2, "invisible disc is not recorded");
+    display_list_reset(&list);
+    check(list.count == 0 && list.used == 0, "reset empties the list");
+    check(display_list_line(&list, 0, 0, 10, 10, 2, 0xFFFF, 255), "line fits after reset");
+}
+
+static void bench() {
+    std::vector<uint32_t> arena(64 * 1024);
+    DisplayList list;
+    display_list_init(&list, arena.data(), arena.size() * 4);
+    srand(7);
+    for (int i = 0; i < 1500; ++i)
+        display_list_disc(&list, rnd(0, 479), rnd(0, 479), rnd(2, 6), (uint16_t)rand(), 200);
+    for (int i = 0; i < 40; ++i)
+        display_list_line(&list, rnd(0, 479), rnd(0, 479), rnd(0, 479), rnd(0, 479), rnd(2, 12), (uint16_t)rand(), 180);
+    for (int i = 0; i < 10; ++i)
+        display_list_arc(&list, 240, 240, rnd(20, 160), rnd(2, 20), rnd(0, 359), rnd(0, 359), (uint16_t)rand(), 180);
+
+    auto canvas = background();
+    using clock = std::chrono::steady_clock;
+    double t[2];
+    for (int tiled = 0; tiled < 2; ++tiled) {
+        int frames = 0;
+        auto start = clock::now();
+        double seconds = 0;
+        do {
+            if (tiled) display_list_replay(&list, canvas.data(), CANVAS, CANVAS, CANVAS);
+            else display_list_replay_rect(&list, canvas.data(), CANVAS, 0, 0, CANVAS - 1, CANVAS - 1);
+            frames++;
+            seconds = std::chrono::duration<double>(clock::now() - start).count();
+        } while (seconds < 0.3);
+        t[tiled] = seconds * 1e3 / frames;
+    }
+    printf("%u records: %.3f ms untiled, %.3f ms tiled per replay\n", (unsigned)list.count, t[0], t[1]);
+}
+
+int main() {
+    srand(1);
+    test_replay(50);
+    test_replay(400);
+    test_replay(3000); // More record/tile pairs than DISPLAY_LIST_MAX_REFS: unbinned fallback
+    test_arena_full();
+    bench();
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
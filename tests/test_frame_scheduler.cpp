@@ -0,0 +1,129 @@
+// Host test for the frame scheduler (frame_scheduler.cpp): layers with
+// synthetic costs (a fixed r1-like layer, and r4/r5-like layers that cost a
+// given time per unit plus some overhead) are planned and "measured" frame
+// after frame. Checks that the total settles near the budget, that a cheap
+// scalable layer keeps all its work while an expensive one is cut down, that
+// the plan follows a change of budget or cost, that a fixed layer with work
+// only in some frames takes its budget only then, and the JSON report.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. tests/test_frame_scheduler.cpp frame_scheduler.cpp -o test_frame_scheduler
+//   ./test_frame_scheduler
+
+#include "frame_scheduler.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+struct Model {
+    float fixed_us;
+    float unit_us;
+};
+
+// Runs frames and returns the average total layer time of the last ten
+static float run(FrameScheduler* s, const Model* models, const int* requested, int frames) {
+    float total = 0;
+    for (int f = 0; f < frames; ++f) {
+        frame_scheduler_plan(s, requested);
+        float frame = 0;
+        for (int i = 0; i < s->count; ++i) {
+            const FrameLayer& l = s->layers[i];
+            if (l.requested == 0) continue;
+            // +-5% jitter so the averages have something to smooth
+            float jitter = 1.0f + 0.05f * (float)((f * 7 + i * 3) % 5 - 2) / 2.0f;
+            float t = (models[i].fixed_us + l.granted * models[i].unit_us) * jitter;
+            frame_scheduler_measure(s, i, s->layers[i].scalable ? l.granted : 1, (uint32_t)t);
+            frame += t;
+        }
+        frame_scheduler_end_frame(s);
+        if (f >= frames - 10) total += frame;
+    }
+    return total / 10;
+}
+
+int main() {
+    FrameScheduler s;
+    frame_scheduler_init(&s, 3, 50000);
+    frame_scheduler_set_scalable(&s, 1, true);
+    frame_scheduler_set_scalable(&s, 2, true);
+
+    // r1-like fixed layer, r4-like dots, r5-like grid of the whole image
+    Model models[3] = { { 800, 0 }, { 200, 4.0f }, { 300, 1.5f } };
+    int requested[3] = { 1, 2000, 230400 };
+    float total = run(&s, models, requested, 40);
+    printf("budget 50 ms: %.1f ms, r4 %d/%d, r5 %d/%d\n", total / 1000, s.layers[1].granted, requested[1],
+           s.layers[2].granted, requested[2]);
+    check(fabsf(total - 50000) < 5000, "total settles within 10% of the budget");
+    check(s.layers[1].granted == requested[1], "cheap scalable layer keeps all its work");
+    check(s.layers[2].granted < requested[2], "expensive layer is cut down");
+    check(s.layers[0].granted == 1, "fixed layer is not scaled");
+
+    // Tighter budget: the share of each scalable layer drops
+    s.budget_us = 10000;
+    total = run(&s, models, requested, 40);
+    printf("budget 10 ms: %.1f ms, r4 %d, r5 %d\n", total / 1000, s.layers[1].granted, s.layers[2].granted);
+    check(fabsf(total - 10000) < 1500, "total follows a smaller budget");
+    check(s.layers[1].granted < requested[1], "both scalable layers are cut when neither fits its share");
+
+    // A layer getting slower (e.g. larger dots) is cut down further
+    int before = s.layers[2].granted;
+    models[2].unit_us = 6.0f;
+    run(&s, models, requested, 40);
+    check(s.layers[2].granted < before / 2, "slower layer does less work");
+
+    // Budget smaller than the fixed layers: scalable layers still do one unit
+    s.budget_us = 500;
+    run(&s, models, requested, 10);
+    check(s.layers[1].granted == 1 && s.layers[2].granted == 1, "at least one unit per enabled layer");
+
+    // Disabled layers get nothing and leave the budget to the others
+    s.budget_us = 50000;
+    int only_r5[3] = { 0, 0, 230400 };
+    run(&s, models, only_r5, 40);
+    check(s.layers[1].granted == 0 && s.layers[1].budget_us == 0, "disabled layer gets no budget");
+    check(s.layers[2].budget_us > 45000, "remaining layer gets the whole budget");
+
+    // A fixed layer that only has work now and then (r0 redrawing when an image
+    // arrives) keeps its measured cost in between and only takes its budget
+    // in the frames it runs
+    FrameScheduler t;
+    frame_scheduler_init(&t, 2, 50000);
+    frame_scheduler_set_scalable(&t, 1, true);
+    Model bg[2] = { { 20000, 0 }, { 100, 10.0f } };
+    int with_bg[2] = { 1, 100000 };
+    int without_bg[2] = { 0, 100000 };
+    run(&t, bg, with_bg, 20);
+    float bg_cost = t.layers[0].cost_us;
+    int granted_with = t.layers[1].granted;
+    run(&t, bg, without_bg, 20);
+    int granted_without = t.layers[1].granted;
+    printf("intermittent fixed layer: r4 %d with it, %d without\n", granted_with, granted_without);
+    check(t.layers[0].budget_us == 0 && t.layers[0].cost_us == bg_cost,
+          "idle fixed layer keeps its cost, takes no budget");
+    check(granted_without > granted_with * 3 / 2, "scalable layer gets the idle layer's budget");
+    frame_scheduler_plan(&t, with_bg);
+    check(t.layers[0].budget_us == (uint32_t)bg_cost && t.layers[1].granted < granted_without,
+          "fixed layer takes its budget again in the frame it runs");
+
+    char json[512];
+    const char* names[3] = { "r1", "r4", "r5" };
+    size_t len = frame_scheduler_format(&s, names, 100, json, sizeof(json));
+    printf("%s\n", json);
+    check(len == strlen(json) && len > 0, "report length");
+    check(strncmp(json, "{\"type\":\"sched\",\"period_ms\":100,\"budget_us\":50000,", 49) == 0, "report header");
+    check(strstr(json, "{\"name\":\"r4\",\"on\":0,") != nullptr, "disabled layer in report");
+    check(json[len - 1] == '}' && json[len - 2] == ']', "report is closed");
+    check(frame_scheduler_format(&s, names, 100, json, 64) == 0, "report refuses a short buffer");
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
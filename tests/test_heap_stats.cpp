@@ -0,0 +1,140 @@
+// Host test for the heap telemetry (heap_stats.h): checks the per-tag and
+// per-region counts through malloc, calloc, realloc and free, the high-water
+// marks, failure counting, the untracked count when the table is full, blocks
+// allocated through the PSRAM pool, two tasks allocating at once, and the
+// {"type":"heap"} message.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -pthread -I. -Ihost tests/test_heap_stats.cpp heap_stats.cpp psram_pool.cpp -o test_heap_stats
+//   ./test_heap_stats
+
+#include "heap_stats.h"
+#include "psram_pool.h"
+#include <esp_heap_caps.h>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static HeapTagStats tag(HeapTag t, HeapRegion r) {
+    HeapTagStats s;
+    heap_stats_get_tag(t, r, &s);
+    return s;
+}
+
+static HeapRegionStats region(HeapRegion r) {
+    HeapRegionStats s;
+    heap_stats_get_region(r, &s);
+    return s;
+}
+
+int main() {
+    // Allocate, count, free
+    void* a = heap_tag_malloc(HEAP_TAG_CANVAS, 1000, MALLOC_CAP_SPIRAM);
+    void* b = heap_tag_malloc(HEAP_TAG_CANVAS, 500, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    void* c = heap_tag_calloc(HEAP_TAG_LVGL, 10, 30, MALLOC_CAP_SPIRAM);
+    check(a && b && c, "allocations succeed");
+    HeapTagStats s = tag(HEAP_TAG_CANVAS, HEAP_REGION_PSRAM);
+    check(s.bytes == 1000 && s.peak == 1000 && s.allocs == 1 && s.frees == 0, "canvas in PSRAM");
+    check(tag(HEAP_TAG_CANVAS, HEAP_REGION_INTERNAL).bytes == 500, "canvas in internal RAM");
+    check(tag(HEAP_TAG_LVGL, HEAP_REGION_PSRAM).bytes == 300, "calloc counts n * size");
+    bool zeroed = true;
+    for (int i = 0; i < 300; ++i) zeroed &= ((uint8_t*)c)[i] == 0;
+    check(zeroed, "calloc zeroes");
+    check(region(HEAP_REGION_PSRAM).bytes == 1300 && region(HEAP_REGION_INTERNAL).bytes == 500, "region totals");
+
+    heap_tag_free(a);
+    s = tag(HEAP_TAG_CANVAS, HEAP_REGION_PSRAM);
+    check(s.bytes == 0 && s.peak == 1000 && s.frees == 1, "free keeps the high-water mark");
+    check(region(HEAP_REGION_PSRAM).bytes == 300 && region(HEAP_REGION_PSRAM).peak == 1300, "region high-water mark");
+    heap_tag_free(b);
+    heap_tag_free(c);
+    heap_tag_free(nullptr);
+
+    // realloc moves the bytes, and may move them to another tag
+    void* j = heap_tag_realloc(HEAP_TAG_JSON, nullptr, 100, MALLOC_CAP_SPIRAM);
+    memset(j, 7, 100);
+    j = heap_tag_realloc(HEAP_TAG_JSON, j, 5000, MALLOC_CAP_SPIRAM);
+    s = tag(HEAP_TAG_JSON, HEAP_REGION_PSRAM);
+    check(j && ((uint8_t*)j)[99] == 7, "realloc keeps the contents");
+    check(s.bytes == 5000 && s.peak == 5000 && s.allocs == 1, "realloc grows the count");
+    j = heap_tag_realloc(HEAP_TAG_JSON, j, 200, MALLOC_CAP_SPIRAM);
+    check(tag(HEAP_TAG_JSON, HEAP_REGION_PSRAM).bytes == 200, "realloc shrinks the count");
+    check(heap_tag_realloc(HEAP_TAG_JSON, j, (size_t)1 << 62, MALLOC_CAP_SPIRAM) == nullptr, "huge realloc fails");
+    s = tag(HEAP_TAG_JSON, HEAP_REGION_PSRAM);
+    check(s.bytes == 200 && s.failures == 1, "failed realloc leaves the block counted");
+    check(heap_tag_realloc(HEAP_TAG_JSON, j, 0, MALLOC_CAP_SPIRAM) == nullptr &&
+          tag(HEAP_TAG_JSON, HEAP_REGION_PSRAM).bytes == 0, "realloc to 0 frees");
+
+    // Failures are counted against the region asked for
+    check(heap_tag_malloc(HEAP_TAG_NET, (size_t)1 << 62, MALLOC_CAP_INTERNAL) == nullptr, "huge malloc fails");
+    s = tag(HEAP_TAG_NET, HEAP_REGION_INTERNAL);
+    check(s.failures == 1 && s.allocs == 0 && s.bytes == 0, "failure counted");
+
+    // A full table still allocates, and counts the rest as untracked
+    static void* many[HEAP_STATS_MAX_BLOCKS + 10];
+    for (int i = 0; i < HEAP_STATS_MAX_BLOCKS + 10; ++i) many[i] = heap_tag_malloc(HEAP_TAG_NET, 16, MALLOC_CAP_SPIRAM);
+    check(heap_stats_untracked() == 10, "blocks beyond the table are untracked");
+    check(tag(HEAP_TAG_NET, HEAP_REGION_PSRAM).bytes == 16 * HEAP_STATS_MAX_BLOCKS, "tracked blocks counted");
+    for (void* p : many) heap_tag_free(p);
+    check(tag(HEAP_TAG_NET, HEAP_REGION_PSRAM).bytes == 0, "untracked frees leave the counts alone");
+
+    // Pool blocks count against the tag that made the pool allocate them
+    void* img = psram_pool_alloc(100000, HEAP_TAG_IMAGE);
+    size_t block = psram_pool_block_size(img);
+    check(tag(HEAP_TAG_IMAGE, HEAP_REGION_PSRAM).bytes > block, "pool block counted with its header");
+    psram_pool_free(img);
+    check(tag(HEAP_TAG_IMAGE, HEAP_REGION_PSRAM).bytes > block, "block held by the pool stays counted");
+    void* again = psram_pool_alloc(100000, HEAP_TAG_BASE64);
+    check(tag(HEAP_TAG_BASE64, HEAP_REGION_PSRAM).allocs == 0, "reuse from the pool is not a heap allocation");
+    psram_pool_free(again);
+    psram_pool_trim();
+    check(tag(HEAP_TAG_IMAGE, HEAP_REGION_PSRAM).bytes == 0, "trim returns the bytes");
+
+    // Two tasks at once
+    auto churn = [](HeapTag t) {
+        for (int i = 0; i < 100000; ++i) {
+            void* p = heap_tag_malloc(t, 64 + i % 64, MALLOC_CAP_SPIRAM);
+            heap_tag_free(p);
+        }
+    };
+    std::thread other(churn, HEAP_TAG_BASE64);
+    churn(HEAP_TAG_JSON);
+    other.join();
+    check(tag(HEAP_TAG_BASE64, HEAP_REGION_PSRAM).bytes == 0 && tag(HEAP_TAG_JSON, HEAP_REGION_PSRAM).bytes == 0 &&
+          tag(HEAP_TAG_BASE64, HEAP_REGION_PSRAM).frees == 100000, "concurrent counts balance");
+
+    // The message
+    char buf[1024];
+    size_t len = heap_stats_format(buf, sizeof(buf));
+    printf("%s\n", buf);
+    check(len == strlen(buf), "format returns the length");
+    check(strncmp(buf, "{\"type\":\"heap\",\"regions\":[{\"name\":\"internal\"", 44) == 0, "message starts with the regions");
+    check(strstr(buf, "{\"name\":\"net\",\"region\":\"internal\",\"bytes\":0,\"peak\":0,\"allocs\":0,\"frees\":0,\"failed\":1}"),
+          "failed-only tag listed");
+    check(!strstr(buf, "\"name\":\"lvgl\",\"region\":\"internal\""), "unused tag and region left out");
+    check(strstr(buf, "\"untracked\":10}") && buf[len - 1] == '}', "message ends with the untracked count");
+    check(heap_stats_format(buf, 100) == 0, "too small a buffer gives 0");
+
+    // Every tag and region listed still fits HEAP_STATS_REPORT_MAX
+    for (int t = 0; t < HEAP_TAG_COUNT; ++t) {
+        heap_tag_free(heap_tag_malloc((HeapTag)t, 8, MALLOC_CAP_SPIRAM));
+        heap_tag_free(heap_tag_malloc((HeapTag)t, 8, MALLOC_CAP_INTERNAL));
+    }
+    static char full[HEAP_STATS_REPORT_MAX];
+    len = heap_stats_format(full, sizeof(full));
+    int entries = 0;
+    for (const char* p = full; (p = strstr(p, "\"region\":")) != nullptr; ++p) entries++;
+    check(len > 0 && entries == HEAP_TAG_COUNT * HEAP_REGION_COUNT, "report with every entry fits");
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
@@ -0,0 +1,136 @@
+// Host test for the layer random number generator (layer_rng.h): checks the
+// xoshiro128** output and jump against the reference values, that seeds and
+// streams are repeatable and independent, that the range, unit and bulk
+// variants stay in range and agree with each other, and roughly that they are
+// uniform. Also times them against Arduino-style random(lo, hi) and frand
+// (modulo and float divide on a shared generator).
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. tests/test_layer_rng.cpp layer_rng.cpp -o test_layer_rng
+//   ./test_layer_rng
+
+#include "layer_rng.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// The sketch's old path: xorshift32 behind random(lo, hi), frand as a float divide
+static uint32_t old_state = 2463534242u;
+static long old_random(long lo, long hi) {
+    uint32_t x = old_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    old_state = x;
+    return lo + (long)(x % (uint32_t)(hi - lo));
+}
+static float old_frand(float a, float b) {
+    return a + ((float)old_random(0, 10000) / 10000.0f) * (b - a);
+}
+
+template <typename F> static double ns_per_call(F f, int calls) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main() {
+    // Reference output of xoshiro128** from the state {1, 2, 3, 4}
+    Rng r = { { 1, 2, 3, 4 } };
+    const uint32_t expected[6] = { 11520, 0, 5927040, 70819200, 2031721883, 1637235492 };
+    bool same = true;
+    for (uint32_t e : expected) same &= rng_next(&r) == e;
+    check(same, "xoshiro128** reference sequence");
+
+    Rng j = { { 1, 2, 3, 4 } };
+    rng_jump(&j);
+    check(j.s[0] == 0xa9765206 && j.s[1] == 0x797aa168 && j.s[2] == 0x5b62e331 && j.s[3] == 0x02abd971,
+          "jump reference state");
+
+    // Seeds and streams
+    Rng a, b;
+    rng_seed(&a, 42, 0);
+    check(rng_next(&a) == 2837322924u && rng_next(&a) == 544945897u, "seed 42 stream 0");
+    rng_seed(&a, 42, 3);
+    check(rng_next(&a) == 2063776457u, "seed 42 stream 3");
+    rng_seed(&a, 42, 2);
+    rng_seed(&b, 42, 0);
+    rng_jump(&b);
+    rng_jump(&b);
+    check(memcmp(&a, &b, sizeof(a)) == 0, "stream n starts n jumps into stream 0");
+
+    Rng streams[6];
+    for (uint32_t s = 0; s < 6; ++s) rng_seed(&streams[s], 7, s);
+    int equal = 0;
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t v[6];
+        for (int s = 0; s < 6; ++s) v[s] = rng_next(&streams[s]);
+        for (int s = 1; s < 6; ++s) equal += v[s] == v[0];
+    }
+    check(equal == 0, "streams differ");
+    rng_seed(&a, 1, 0);
+    rng_seed(&b, 2, 0);
+    check(rng_next(&a) != rng_next(&b), "nearby seeds differ");
+    rng_seed(&a, 0, 0);
+    check((a.s[0] | a.s[1] | a.s[2] | a.s[3]) != 0, "seed 0 is usable");
+
+    // Ranges
+    rng_seed(&a, 3, 1);
+    bool in_range = true;
+    int hist[10] = { 0 };
+    const int draws = 1000000;
+    for (int i = 0; i < draws; ++i) {
+        uint32_t v = rng_below(&a, 10);
+        in_range &= v < 10;
+        hist[v < 10 ? v : 0]++;
+        int32_t w = rng_between(&a, -5, 7);
+        in_range &= w >= -5 && w < 7;
+        in_range &= rng_unit_q16(&a) < 65536;
+        float u = rng_unit(&a);
+        in_range &= u >= 0.0f && u < 1.0f;
+    }
+    check(in_range, "range, unit and fixed-point unit stay in range");
+    check(rng_between(&a, 5, 5) == 5 && rng_between(&a, 5, 3) == 5, "empty range gives lo");
+    check(rng_below(&a, 1) == 0, "below 1");
+    double chi2 = 0;
+    for (int h : hist) chi2 += (h - draws / 10.0) * (h - draws / 10.0) / (draws / 10.0);
+    check(chi2 < 27.9, "rng_below(10) is uniform (chi-square, 9 dof, p = 0.001)");
+
+    // Bulk fill gives exactly what single calls give
+    rng_seed(&a, 11, 4);
+    b = a;
+    uint16_t bulk[1000];
+    rng_fill_below(&a, bulk, 1000, 480);
+    bool match = true;
+    for (int i = 0; i < 1000; ++i) match &= bulk[i] == rng_below(&b, 480);
+    check(match && memcmp(&a, &b, sizeof(a)) == 0, "bulk fill matches rng_below");
+    rng_fill_below(&a, bulk, 1000, 65536);
+    match = true;
+    for (int i = 0; i < 1000; ++i) match &= bulk[i] == rng_below(&b, 65536);
+    check(match, "bulk fill over the full 16-bit range");
+
+    // Cost against the old path
+    const int calls = 20000000;
+    volatile uint32_t sink = 0;
+    rng_seed(&a, 5, 0);
+    double old_int = ns_per_call([&] { sink = sink + (uint32_t)old_random(0, 480); }, calls);
+    double new_int = ns_per_call([&] { sink = sink + rng_below(&a, 480); }, calls);
+    double old_f = ns_per_call([&] { sink = sink + (uint32_t)(old_frand(0.1f, 0.9f) * 480); }, calls);
+    double new_f = ns_per_call([&] { sink = sink + (uint32_t)((0.1f + rng_unit(&a) * 0.8f) * 480); }, calls);
+    static uint16_t xs[4096];
+    double bulk_ns = ns_per_call([&] { rng_fill_below(&a, xs, 4096, 480); sink = sink + xs[17]; }, calls / 4096) / 4096;
+    printf("ns per number on the host: random(0, 480) %.2f, rng_below %.2f, bulk fill %.2f; "
+           "frand %.2f, rng_unit %.2f\n", old_int, new_int, bulk_ns, old_f, new_f);
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
@@ -0,0 +1,90 @@
+// Host test for the PSRAM block pool (psram_pool.cpp): simulates a stream of
+// image messages (base64 scratch of varying size plus double-buffered pixel
+// buffers whose dimensions change now and then) and checks that after warm-up
+// nothing is allocated from the heap any more.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. -Ihost tests/test_psram_pool.cpp psram_pool.cpp heap_stats.cpp image_buffer.cpp -o test_psram_pool
+//   ./test_psram_pool
+
+#include "psram_pool.h"
+#include "image_buffer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static void test_block_sizes() {
+    const size_t sizes[] = { 1, 4096, 4097, 5120, 30000, 460800, 1000000, PSRAM_POOL_MAX_BLOCK };
+    for (size_t size : sizes) {
+        void* p = psram_pool_alloc(size, HEAP_TAG_IMAGE);
+        size_t block = psram_pool_block_size(p);
+        check(p != nullptr, "allocation");
+        check(block >= size && block <= size + size / 4 + PSRAM_POOL_MIN_BLOCK, "block size within class bounds");
+        memset(p, 0xA5, block);
+        psram_pool_free(p);
+    }
+    // Oversized requests bypass the pool
+    void* big = psram_pool_alloc(PSRAM_POOL_MAX_BLOCK + 1, HEAP_TAG_IMAGE);
+    check(psram_pool_block_size(big) == PSRAM_POOL_MAX_BLOCK + 1, "direct allocation size");
+    psram_pool_free(big);
+    psram_pool_trim();
+
+    PsramPoolStats s;
+    psram_pool_get_stats(&s);
+    check(s.bytes_in_use == 0 && s.bytes_held == 0, "nothing in use or held after trim");
+}
+
+static void test_streaming() {
+    static uint16_t initial[16 * 16];
+    image_buffer_init(initial, 16, 16);
+    const int dims[][2] = { { 480, 480 }, { 320, 240 }, { 480, 480 }, { 240, 240 } };
+
+    PsramPoolStats warm = {};
+    srand(1);
+    for (int frame = 0; frame < 2000; ++frame) {
+        if (frame == 200) psram_pool_get_stats(&warm);
+
+        // base64 scratch: JPEG sizes vary a few KB around 40 KB
+        size_t jpeg_len = 38000 + rand() % 4000;
+        uint8_t* scratch = (uint8_t*)psram_pool_alloc(jpeg_len, HEAP_TAG_BASE64);
+        check(scratch != nullptr, "scratch allocation");
+
+        // Dimensions change every 50 frames
+        const int* d = dims[(frame / 50) % 4];
+        ImageFrame* back = image_buffer_begin_write(d[0], d[1]);
+        check(back != nullptr, "back buffer");
+        if (back) {
+            memset(back->pixels, frame & 0xFF, (size_t)d[0] * d[1] * sizeof(uint16_t));
+            image_buffer_publish(back);
+        }
+        psram_pool_free(scratch);
+
+        const ImageFrame* front = image_buffer_acquire();
+        check(front->width == d[0] && front->height == d[1], "published dimensions");
+        image_buffer_release(front);
+    }
+
+    PsramPoolStats end;
+    psram_pool_get_stats(&end);
+    printf("after warm-up: %u hits, %u misses; total: %u hits, %u misses, %zu bytes in use, %zu bytes held\n",
+           (unsigned)(end.hits - warm.hits), (unsigned)(end.misses - warm.misses), (unsigned)end.hits,
+           (unsigned)end.misses, end.bytes_in_use, end.bytes_held);
+    check(end.misses == warm.misses, "no heap allocations in steady state");
+}
+
+int main() {
+    test_block_sizes();
+    test_streaming();
+    if (failures) printf("%d failures\n", failures);
+    else printf("all passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+// Host test for the render job system (render_jobs.cpp) with its std::thread
+// worker: batches of every size must run each job exactly once and be
+// complete when render_jobs_run returns, including back-to-back batches that
+// the worker wakes up late for. Then a display list of pointillist dots is
+// replayed band by band through the jobs and compared with the serial
+// replay, and both are timed with the worker enabled and disabled.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -pthread -I. tests/test_render_jobs.cpp render_jobs.cpp display_list.cpp disc_splat.cpp rgb565_blend.cpp -o test_render_jobs
+//   ./test_render_jobs
+
+#include "render_jobs.h"
+#include "display_list.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define CANVAS 480
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+struct CountCtx {
+    std::atomic<int> hits[64];
+    std::atomic<int> sink;
+};
+
+static void count_job(void* ctx, int index) {
+    CountCtx* c = (CountCtx*)ctx;
+    int s = 0;
+    for (int i = 0; i < (index % 7) * 200; ++i) s += i * index; // Uneven job lengths
+    c->sink.store(s, std::memory_order_relaxed);
+    c->hits[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+static void test_batches() {
+    static CountCtx ctx;
+    int bad = 0;
+    for (int round = 0; round < 20000; ++round) {
+        int count = round % 65;
+        for (int i = 0; i < 64; ++i) ctx.hits[i].store(0, std::memory_order_relaxed);
+        render_jobs_run(count_job, &ctx, count);
+        for (int i = 0; i < 64; ++i) bad += ctx.hits[i].load(std::memory_order_relaxed) != (i < count ? 1 : 0);
+    }
+    check(bad == 0, "every job runs exactly once per batch");
+}
+
+struct BandCtx {
+    const DisplayList* list;
+    uint16_t* dst;
+};
+
+static void band_job(void* ctx, int band) {
+    BandCtx* c = (BandCtx*)ctx;
+    display_list_replay_band(c->list, c->dst, CANVAS, band);
+}
+
+// r5-style grid of dots with an r1-style line on top
+static void record_frame(DisplayList* list, int grid, int radius) {
+    float cell = (float)CANVAS / grid;
+    for (int r = 0; r < grid; ++r)
+        for (int c = 0; c < grid; ++c)
+            display_list_disc(list, (int)((c + 0.5f) * cell), (int)((r + 0.5f) * cell), radius,
+                              (uint16_t)(r * 2654435761u + c * 40503u), 255);
+    display_list_line(list, 10, 20, 470, 400, 9, 0xF800, 160);
+}
+
+static double replay_ms(const DisplayList* list, std::vector<uint16_t>& canvas) {
+    using clock = std::chrono::steady_clock;
+    BandCtx ctx = { list, canvas.data() };
+    int frames = 0;
+    auto start = clock::now();
+    double seconds = 0;
+    do {
+        render_jobs_run(band_job, &ctx, display_list_bin(list, CANVAS, CANVAS));
+        frames++;
+        seconds = std::chrono::duration<double>(clock::now() - start).count();
+    } while (seconds < 0.3);
+    return seconds * 1e3 / frames;
+}
+
+static void test_banded_replay() {
+    std::vector<uint32_t> arena(16 * 1024);
+    DisplayList list;
+    display_list_init(&list, arena.data(), arena.size() * 4);
+    const int grids[] = { 24, 48, 60 };
+    for (int grid : grids) {
+        display_list_reset(&list);
+        record_frame(&list, grid, CANVAS / grid / 2);
+
+        std::vector<uint16_t> serial(CANVAS * CANVAS, 0x1234), banded(CANVAS * CANVAS, 0x1234);
+        display_list_replay(&list, serial.data(), CANVAS, CANVAS, CANVAS);
+        BandCtx ctx = { &list, banded.data() };
+        render_jobs_run(band_job, &ctx, display_list_bin(&list, CANVAS, CANVAS));
+        check(serial == banded, "banded replay through jobs matches the serial replay");
+
+        render_jobs_set_enabled(false);
+        double one = replay_ms(&list, serial);
+        render_jobs_set_enabled(true);
+        double two = replay_ms(&list, serial);
+        printf("%2dx%-2d dots (%4u records): %.3f ms on one thread, %.3f ms on two (%.2fx)\n", grid, grid,
+               (unsigned)list.count, one, two, one / two);
+    }
+}
+
+int main() {
+    test_batches(); // Before render_jobs_init: everything runs on the caller
+    check(render_jobs_init(), "worker starts");
+    test_batches();
+    test_banded_replay();
+
+    RenderJobStats s;
+    render_jobs_get_stats(&s);
+    printf("%u batches, %u jobs, %u run by the worker\n", s.batches, s.jobs, s.worker_jobs);
+    check(s.worker_jobs > 0, "the worker takes jobs");
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
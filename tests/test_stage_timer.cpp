@@ -0,0 +1,84 @@
+// Host test for the stage timers (stage_timer.cpp): known per-frame times go
+// in through stage_add, and the {"type":"stats"} summary must report the
+// right min, mean, 95th percentile and max for each stage, skip frames and
+// stages that did not run, start a new window after every report and keep
+// only the last STAGE_RING_FRAMES frames. Also times a scope, to show the
+// overhead of leaving the timers enabled.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. tests/test_stage_timer.cpp stage_timer.cpp -o test_stage_timer
+//   ./test_stage_timer
+
+#include "stage_timer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// On the host a "cycle" is a nanosecond
+static void add_us(Stage stage, uint32_t us) {
+    stage_add(stage, us * 1000);
+}
+
+int main() {
+    char json[1024];
+
+    // r4 takes 1..100 us over 100 frames; json runs in every tenth frame only
+    for (uint32_t f = 1; f <= 100; ++f) {
+        add_us(STAGE_R4, f);
+        if (f % 10 == 0) add_us(STAGE_JSON, 50);
+        if (f % 10 == 0) add_us(STAGE_JSON, 25); // Two messages in one frame add up
+        stage_timer_end_frame();
+    }
+    size_t len = stage_timer_format(json, sizeof(json));
+    printf("%s\n", json);
+    check(len == strlen(json) && len > 0, "report length");
+    check(strncmp(json, "{\"type\":\"stats\",\"frames\":100,\"stages\":[", 39) == 0, "report header");
+    check(strstr(json, "{\"name\":\"json\",\"n\":10,\"min\":75,\"mean\":75,\"p95\":75,\"max\":75}") != nullptr,
+          "stage that ran in some frames");
+    check(strstr(json, "{\"name\":\"r4\",\"n\":100,\"min\":1,\"mean\":50,\"p95\":95,\"max\":100}") != nullptr,
+          "min, mean, p95 and max");
+    check(strstr(json, "\"r5\"") == nullptr, "stages that never ran are left out");
+
+    // A new window: only the frames since the last report count
+    add_us(STAGE_FLUSH, 300);
+    stage_timer_end_frame();
+    len = stage_timer_format(json, sizeof(json));
+    check(strcmp(json, "{\"type\":\"stats\",\"frames\":1,\"stages\":[{\"name\":\"flush\",\"n\":1,\"min\":300,"
+                       "\"mean\":300,\"p95\":300,\"max\":300}]}") == 0, "window restarts after a report");
+
+    // More frames than the ring holds: the oldest are forgotten
+    for (uint32_t f = 0; f < STAGE_RING_FRAMES + 50; ++f) {
+        add_us(STAGE_LVGL, f < 50 ? 1000 : 10);
+        stage_timer_end_frame();
+    }
+    stage_timer_format(json, sizeof(json));
+    check(strstr(json, "\"frames\":178") != nullptr, "window counts every frame");
+    check(strstr(json, "{\"name\":\"lvgl\",\"n\":128,\"min\":10,\"mean\":10,\"p95\":10,\"max\":10}") != nullptr,
+          "only the last STAGE_RING_FRAMES frames are summarized");
+
+    stage_timer_end_frame();
+    len = stage_timer_format(json, sizeof(json));
+    check(strcmp(json, "{\"type\":\"stats\",\"frames\":1,\"stages\":[]}") == 0, "empty frame");
+    check(stage_timer_format(json, 16) == 0, "report refuses a short buffer");
+
+    // Overhead of a scope
+    const int scopes = 10000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < scopes; ++i) {
+        StageScope scope(STAGE_R1);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / scopes;
+    printf("%.1f ns per scope on the host (two clock reads and an atomic add)\n", ns);
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
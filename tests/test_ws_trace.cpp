@@ -0,0 +1,86 @@
+// Host test for WebSocket session traces (ws_trace.cpp): events written by the
+// recorder must read back with the same times, types and payloads; an event
+// that does not fit stops the recording without damaging the trace; and the
+// reader must reject foreign data and stop at a truncated record.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. tests/test_ws_trace.cpp ws_trace.cpp -o test_ws_trace
+//   ./test_ws_trace
+
+#include "ws_trace.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool cond, const char* what) {
+    if (!cond) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+int main() {
+    std::vector<uint8_t> buf(256);
+    WsTraceWriter w;
+    ws_trace_init(&w, buf.data(), buf.size());
+    check(!ws_trace_record(&w, 0, 3, nullptr, 0), "nothing is recorded before start");
+
+    const char text[] = "{\"type\":\"slider\",\"value\":0.25}";
+    const uint8_t bin[] = { 'L', 'F', 1, 1, 2, 0 };
+    check(ws_trace_start(&w, 1000), "start");
+    check(ws_trace_record(&w, 1000, 2, (const uint8_t*)"/", 1), "connected event");
+    check(ws_trace_record(&w, 1040, 3, (const uint8_t*)text, strlen(text)), "text event");
+    check(ws_trace_record(&w, 1100, 4, bin, sizeof(bin)), "binary event");
+    check(ws_trace_record(&w, 1100, 9, nullptr, 0), "empty payload");
+    ws_trace_stop(&w);
+    check(!ws_trace_record(&w, 1200, 3, (const uint8_t*)text, 4), "nothing is recorded after stop");
+    check(w.records == 4, "record count");
+    check(w.len == WS_TRACE_HEADER_SIZE + 4 * WS_TRACE_RECORD_HEADER_SIZE + 1 + strlen(text) + sizeof(bin),
+          "trace length");
+
+    WsTraceReader r;
+    WsTraceEvent ev;
+    check(ws_trace_reader_init(&r, buf.data(), w.len), "header");
+    check(ws_trace_next(&r, &ev) && ev.time_ms == 0 && ev.type == 2 && ev.len == 1 && ev.payload[0] == '/',
+          "first event, times relative to start");
+    check(ws_trace_next(&r, &ev) && ev.time_ms == 40 && ev.type == 3 && ev.len == strlen(text) &&
+          memcmp(ev.payload, text, ev.len) == 0, "text event reads back");
+    check(ws_trace_next(&r, &ev) && ev.time_ms == 100 && ev.type == 4 && ev.len == sizeof(bin) &&
+          memcmp(ev.payload, bin, ev.len) == 0, "binary event reads back");
+    check(ws_trace_next(&r, &ev) && ev.type == 9 && ev.len == 0, "empty payload reads back");
+    check(!ws_trace_next(&r, &ev), "end of trace");
+
+    // Truncated: the last record loses a byte and is not returned
+    check(ws_trace_reader_init(&r, buf.data(), w.len - WS_TRACE_RECORD_HEADER_SIZE - 1), "truncated header");
+    int n = 0;
+    while (ws_trace_next(&r, &ev)) n++;
+    check(n == 2, "reader stops at a truncated record");
+
+    // Overflow: recording stops at the event that does not fit
+    std::vector<uint8_t> big(300, 0xAB);
+    check(ws_trace_start(&w, 0), "restart");
+    check(ws_trace_record(&w, 5, 3, (const uint8_t*)text, strlen(text)), "fits");
+    size_t len_before = w.len;
+    check(!ws_trace_record(&w, 6, 4, big.data(), big.size()), "oversized event is refused");
+    check(w.overflowed && !w.recording && w.len == len_before, "overflow stops the recording");
+    check(!ws_trace_record(&w, 7, 3, (const uint8_t*)text, 1), "and nothing follows it");
+    check(ws_trace_reader_init(&r, buf.data(), w.len) && ws_trace_next(&r, &ev) && ev.time_ms == 5 &&
+          !ws_trace_next(&r, &ev), "trace is intact up to the overflow");
+
+    // Not a trace
+    const uint8_t other[] = "WSTX\x01\0\0\0";
+    check(!ws_trace_reader_init(&r, other, 8), "wrong magic");
+    uint8_t future[8] = { 'W', 'S', 'T', 'R', WS_TRACE_VERSION + 1, 0, 0, 0 };
+    check(!ws_trace_reader_init(&r, future, 8), "wrong version");
+    check(!ws_trace_reader_init(&r, buf.data(), 4), "too short");
+
+    WsTraceWriter tiny;
+    uint8_t small[4];
+    ws_trace_init(&tiny, small, sizeof(small));
+    check(!ws_trace_start(&tiny, 0) && !tiny.recording, "buffer too small for the header");
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures != 0;
+}
@@ -0,0 +1,205 @@
+#include "ws_control.h"
+#include <string.h>
+
+struct Cursor {
+    const char* p;
+    const char* end;
+};
+
+struct Span {
+    const char* p;
+    size_t len;
+    bool escaped;
+};
+
+static void skip_ws(Cursor* c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\n' || *c->p == '\r')) c->p++;
+}
+
+static bool consume(Cursor* c, char ch) {
+    skip_ws(c);
+    if (c->p >= c->end || *c->p != ch) return false;
+    c->p++;
+    return true;
+}
+
+// Reads a string token without copying it; escapes are resolved later if needed
+static bool read_string(Cursor* c, Span* out) {
+    if (!consume(c, '"')) return false;
+    out->p = c->p;
+    out->escaped = false;
+    while (c->p < c->end) {
+        char ch = *c->p;
+        if (ch == '"') {
+            out->len = (size_t)(c->p - out->p);
+            c->p++;
+            return true;
+        }
+        if (ch == '\\') {
+            out->escaped = true;
+            c->p++; // skip the escaped character
+        }
+        c->p++;
+    }
+    return false;
+}
+
+static bool read_number(Cursor* c, float* out) {
+    skip_ws(c);
+    const char* p = c->p;
+    bool neg = false;
+    if (p < c->end && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+    if (p >= c->end || *p < '0' || *p > '9') return false;
+
+    double v = 0.0;
+    while (p < c->end && *p >= '0' && *p <= '9') v = v * 10.0 + (*p++ - '0');
+    if (p < c->end && *p == '.') {
+        p++;
+        double scale = 0.1;
+        while (p < c->end && *p >= '0' && *p <= '9') {
+            v += (*p++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (p < c->end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_neg = false;
+        if (p < c->end && (*p == '-' || *p == '+')) exp_neg = (*p++ == '-');
+        if (p >= c->end || *p < '0' || *p > '9') return false;
+        int e = 0;
+        while (p < c->end && *p >= '0' && *p <= '9') {
+            if (e < 400) e = e * 10 + (*p - '0');
+            p++;
+        }
+        while (e-- > 0) v = exp_neg ? v * 0.1 : v * 10.0;
+    }
+    c->p = p;
+    *out = (float)(neg ? -v : v);
+    return true;
+}
+
+static bool span_equals(const Span& s, const char* lit) {
+    size_t n = strlen(lit);
+    return !s.escaped && s.len == n && memcmp(s.p, lit, n) == 0;
+}
+
+static int hex_digit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+// Copies a string span into buf, resolving JSON escapes. Output is truncated to cap - 1 bytes.
+static size_t unescape(const Span& s, char* buf, size_t cap) {
+    size_t o = 0;
+    const char* p = s.p;
+    const char* end = s.p + s.len;
+    char tmp[4];
+    while (p < end) {
+        size_t n = 1;
+        tmp[0] = *p++;
+        if (tmp[0] == '\\' && p < end) {
+            char e = *p++;
+            switch (e) {
+            case 'n': tmp[0] = '\n'; break;
+            case 't': tmp[0] = '\t'; break;
+            case 'r': tmp[0] = '\r'; break;
+            case 'b': tmp[0] = '\b'; break;
+            case 'f': tmp[0] = '\f'; break;
+            case 'u': {
+                unsigned cp = 0;
+                for (int i = 0; i < 4 && p < end; ++i) {
+                    int d = hex_digit(*p++);
+                    cp = (cp << 4) | (unsigned)(d < 0 ? 0 : d);
+                }
+                // Encode the BMP code point as UTF-8 (surrogate pairs are passed through as-is)
+                if (cp < 0x80) {
+                    tmp[0] = (char)cp;
+                } else if (cp < 0x800) {
+                    tmp[0] = (char)(0xC0 | (cp >> 6));
+                    tmp[1] = (char)(0x80 | (cp & 0x3F));
+                    n = 2;
+                } else {
+                    tmp[0] = (char)(0xE0 | (cp >> 12));
+                    tmp[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    tmp[2] = (char)(0x80 | (cp & 0x3F));
+                    n = 3;
+                }
+                break;
+            }
+            default: tmp[0] = e; break; // \" \\ \/
+            }
+        }
+        if (o + n > cap - 1) break;
+        memcpy(buf + o, tmp, n);
+        o += n;
+    }
+    buf[o] = '\0';
+    return o;
+}
+
+bool ws_control_parse(const char* json, size_t len, WsControlMsg* out, char* text_buf, size_t text_cap) {
+    if (!json || !out) return false;
+    out->type = WS_CONTROL_NONE;
+    out->value = 0.0f;
+    out->text_len = 0;
+
+    Cursor c = { json, json + len };
+    if (!consume(&c, '{')) return false;
+
+    WsControlType type = WS_CONTROL_NONE;
+    bool have_num = false, have_str = false;
+    float num = 0.0f;
+    Span str = { nullptr, 0, false };
+
+    skip_ws(&c);
+    if (c.p < c.end && *c.p == '}') return false; // empty object
+
+    for (;;) {
+        Span key;
+        if (!read_string(&c, &key) || !consume(&c, ':')) return false;
+        skip_ws(&c);
+        if (c.p >= c.end) return false;
+
+        if (span_equals(key, "type")) {
+            Span t;
+            if (!read_string(&c, &t)) return false;
+            if (span_equals(t, "slider")) type = WS_CONTROL_SLIDER;
+            else if (span_equals(t, "number")) type = WS_CONTROL_NUMBER;
+            else if (span_equals(t, "text")) type = WS_CONTROL_TEXT;
+            else return false; // image or unknown: not a control message
+        } else if (*c.p == '"') {
+            Span v;
+            if (!read_string(&c, &v)) return false;
+            if (span_equals(key, "value")) { str = v; have_str = true; }
+        } else if (*c.p == '-' || (*c.p >= '0' && *c.p <= '9')) {
+            float v;
+            if (!read_number(&c, &v)) return false;
+            if (span_equals(key, "value")) { num = v; have_num = true; }
+        } else {
+            // Literals, objects and arrays are left to the full parser
+            return false;
+        }
+
+        if (consume(&c, ',')) continue;
+        if (consume(&c, '}')) break;
+        return false;
+    }
+
+    switch (type) {
+    case WS_CONTROL_SLIDER:
+    case WS_CONTROL_NUMBER:
+        if (!have_num) return false;
+        out->value = num;
+        break;
+    case WS_CONTROL_TEXT:
+        if (!have_str || !text_buf || text_cap == 0) return false;
+        out->text_len = unescape(str, text_buf, text_cap);
+        break;
+    default:
+        return false;
+    }
+    out->type = type;
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Allocation-free parser for the small control messages sent on every
+// slider tick:
+//   { "type": "slider", "value": 0.4 }
+//   { "type": "number", "value": 2 }
+//   { "type": "text",   "value": "r2 on" }
+// Anything else (images, unknown types, nested values) is rejected so the
+// caller can fall back to the full ArduinoJson path.
+
+enum WsControlType : uint8_t {
+    WS_CONTROL_NONE = 0,
+    WS_CONTROL_SLIDER,
+    WS_CONTROL_NUMBER,
+    WS_CONTROL_TEXT,
+};
+
+struct WsControlMsg {
+    WsControlType type;
+    float value;     // slider / number
+    size_t text_len; // text: bytes written to text_buf, excluding the terminator
+};
+
+// Parses json[0..len). For text messages the unescaped value is written to
+// text_buf (always null-terminated, truncated to text_cap - 1 bytes).
+// Returns true if the message was a complete control message.
+bool ws_control_parse(const char* json, size_t len, WsControlMsg* out, char* text_buf, size_t text_cap);
@@ -0,0 +1,63 @@
+#include "ws_frame.h"
+
+static uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool ws_frame_parse_header(const uint8_t* data, size_t len, WsFrameHeader* hdr) {
+    if (!data || !hdr || len < WS_FRAME_HEADER_SIZE) return false;
+    if (data[0] != WS_FRAME_MAGIC0 || data[1] != WS_FRAME_MAGIC1) return false;
+
+    hdr->version = data[2];
+    if (hdr->version != WS_FRAME_VERSION) return false;
+
+    hdr->type = data[3];
+    hdr->codec = data[4];
+    hdr->flags = data[5];
+    hdr->width = read_u16(data + 6);
+    hdr->height = read_u16(data + 8);
+    hdr->seq = read_u32(data + 12);
+    hdr->payload_len = read_u32(data + 16);
+    return true;
+}
+
+bool ws_frame_parse(const uint8_t* data, size_t len, WsFrameHeader* hdr, const uint8_t** payload) {
+    if (!ws_frame_parse_header(data, len, hdr)) return false;
+
+    // The payload must be complete; trailing bytes are tolerated for forward compatibility
+    if (hdr->payload_len > len - WS_FRAME_HEADER_SIZE) return false;
+
+    if (payload) *payload = data + WS_FRAME_HEADER_SIZE;
+    return true;
+}
+
+bool ws_frame_tiles_begin(const uint8_t* payload, size_t len, WsTileReader* reader) {
+    if (!payload || !reader || len < 2) return false;
+    reader->remaining = read_u16(payload);
+    reader->pos = payload + 2;
+    reader->end = payload + len;
+    return true;
+}
+
+bool ws_frame_next_tile(WsTileReader* reader, int image_width, int image_height, WsFrameTile* tile) {
+    if (reader->remaining == 0) return false;
+    if ((size_t)(reader->end - reader->pos) < WS_FRAME_TILE_HEADER_SIZE) return false;
+
+    tile->x = read_u16(reader->pos);
+    tile->y = read_u16(reader->pos + 2);
+    tile->w = read_u16(reader->pos + 4);
+    tile->h = read_u16(reader->pos + 6);
+    if (tile->w == 0 || tile->h == 0 || tile->x + tile->w > image_width || tile->y + tile->h > image_height) return false;
+
+    size_t pixel_bytes = (size_t)tile->w * tile->h * 2;
+    if ((size_t)(reader->end - reader->pos) - WS_FRAME_TILE_HEADER_SIZE < pixel_bytes) return false;
+
+    tile->pixels = reader->pos + WS_FRAME_TILE_HEADER_SIZE;
+    reader->pos += WS_FRAME_TILE_HEADER_SIZE + pixel_bytes;
+    reader->remaining--;
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary WebSocket frame format (WStype_BIN), little-endian:
+//
+//   offset size field
+//   0      2    magic 'L' 'F'
+//   2      1    version (WS_FRAME_VERSION)
+//   3      1    type    (WsFrameType)
+//   4      1    codec   (WsFrameCodec)
+//   5      1    flags   (reserved, send 0)
+//   6      2    width
+//   8      2    height
+//   10     2    reserved (send 0)
+//   12     4    sequence number
+//   16     4    payload length in bytes
+//   20     ...  payload
+//
+// The payload is passed to the decoder as-is, so an image costs no base64
+// or JSON pass on the device.
+//
+// WS_FRAME_TYPE_TILES frames patch the current image instead of replacing it.
+// width/height give the size of the image being patched, codec is
+// WS_FRAME_CODEC_RGB565 and the payload is:
+//
+//   0      2    tile count
+//   2      ...  tiles, each: x, y, w, h (2 bytes each) followed by w * h
+//               RGB565 pixels, row by row
+//
+// A tile frame applies on top of the frame with the previous sequence
+// number; the device asks for a full frame when it cannot apply one.
+
+#define WS_FRAME_MAGIC0 'L'
+#define WS_FRAME_MAGIC1 'F'
+#define WS_FRAME_VERSION 1
+#define WS_FRAME_HEADER_SIZE 20
+#define WS_FRAME_TILE_HEADER_SIZE 8
+
+enum WsFrameType : uint8_t {
+    WS_FRAME_TYPE_IMAGE = 1,
+    WS_FRAME_TYPE_TILES = 2, // changed regions of the previous image
+};
+
+enum WsFrameCodec : uint8_t {
+    WS_FRAME_CODEC_JPEG = 1,
+    WS_FRAME_CODEC_RGB565 = 2, // raw RGB565 little-endian, width * height * 2 bytes
+};
+
+struct WsFrameHeader {
+    uint8_t version;
+    uint8_t type;
+    uint8_t codec;
+    uint8_t flags;
+    uint16_t width;
+    uint16_t height;
+    uint32_t seq;
+    uint32_t payload_len;
+};
+
+struct WsFrameTile {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    const uint8_t* pixels; // w * h RGB565 little-endian, not necessarily aligned
+};
+
+// Iterates the tiles of a WS_FRAME_TYPE_TILES payload
+struct WsTileReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+    uint16_t remaining;
+};
+
+// Parses only the header. Used on the first fragment of a message to learn its
+// total size (WS_FRAME_HEADER_SIZE + payload_len) before the rest arrives.
+bool ws_frame_parse_header(const uint8_t* data, size_t len, WsFrameHeader* hdr);
+
+// Parses the header at the start of a binary message.
+// Returns true if the header is valid and the whole payload is present;
+// *payload then points just past the header.
+bool ws_frame_parse(const uint8_t* data, size_t len, WsFrameHeader* hdr, const uint8_t** payload);
+
+// Starts reading the tiles of a tile frame payload. Returns false if the
+// payload is too short to hold the tile count.
+bool ws_frame_tiles_begin(const uint8_t* payload, size_t len, WsTileReader* reader);
+
+// Reads the next tile. Returns false when all tiles were read or the payload
+// is truncated; tiles outside image_width x image_height are also rejected.
+bool ws_frame_next_tile(WsTileReader* reader, int image_width, int image_height, WsFrameTile* tile);
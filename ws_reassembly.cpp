@@ -0,0 +1,57 @@
+#include "ws_reassembly.h"
+#include "ws_frame.h"
+#include <string.h>
+
+void ws_reassembly_init(WsReassembly* r, uint8_t* buf, size_t capacity) {
+    memset(r, 0, sizeof(*r));
+    r->buf = buf;
+    r->capacity = buf ? capacity : 0;
+}
+
+static bool reject(WsReassembly* r) {
+    if (!r->rejected) r->rejected_count++;
+    r->rejected = true;
+    r->len = 0;
+    return false;
+}
+
+bool ws_reassembly_begin(WsReassembly* r, bool binary, const uint8_t* data, size_t len) {
+    r->active = true;
+    r->rejected = false;
+    r->binary = binary;
+    r->len = 0;
+    r->expected = 0;
+
+    if (binary) {
+        // The header must arrive in one piece so the total size is known up front
+        WsFrameHeader hdr;
+        if (!ws_frame_parse_header(data, len, &hdr)) return reject(r);
+        // Compared before adding: on the 32-bit target the sum can wrap to 0,
+        // which would turn off the size check in ws_reassembly_append
+        if (r->capacity < WS_FRAME_HEADER_SIZE || hdr.payload_len > r->capacity - WS_FRAME_HEADER_SIZE) return reject(r);
+        r->expected = (size_t)WS_FRAME_HEADER_SIZE + hdr.payload_len;
+    }
+    return ws_reassembly_append(r, data, len);
+}
+
+bool ws_reassembly_append(WsReassembly* r, const uint8_t* data, size_t len) {
+    if (!r->active || r->rejected) return false;
+    if (len > r->capacity - r->len) return reject(r);
+    if (r->expected && r->len + len > r->expected) return reject(r);
+    memcpy(r->buf + r->len, data, len);
+    r->len += len;
+    return true;
+}
+
+bool ws_reassembly_finish(WsReassembly* r, const uint8_t* data, size_t len, uint8_t** msg, size_t* msg_len) {
+    bool ok = ws_reassembly_append(r, data, len);
+    r->active = false;
+    if (!ok) return false;
+    if (r->expected && r->len != r->expected) return reject(r); // truncated frame
+
+    if (!r->binary) r->buf[r->len] = '\0';
+    r->completed_count++;
+    *msg = r->buf;
+    *msg_len = r->len;
+    return true;
+}
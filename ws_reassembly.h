@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Reassembles fragmented WebSocket messages into a fixed, caller-provided
+// arena (allocated once in PSRAM). Nothing is allocated per message, so the
+// peak memory of a message is bounded by the arena capacity.
+//
+// Binary messages start with a ws_frame.h header; its payload length is read
+// from the first fragment and oversized messages are rejected before any of
+// their data is buffered. Text messages have no length field and are
+// rejected as soon as they outgrow the arena.
+
+struct WsReassembly {
+    uint8_t* buf;      // capacity + 1 bytes (room for a terminator on text messages)
+    size_t capacity;
+    size_t len;        // bytes buffered so far
+    size_t expected;   // total size announced by the first fragment, 0 if unknown
+    bool binary;
+    bool active;       // a message is being assembled
+    bool rejected;     // the current message is being skipped
+    uint32_t completed_count;
+    uint32_t rejected_count;
+};
+
+// buf must hold capacity + 1 bytes
+void ws_reassembly_init(WsReassembly* r, uint8_t* buf, size_t capacity);
+
+// First fragment (WStype_FRAGMENT_TEXT_START / WStype_FRAGMENT_BIN_START).
+// Returns false if the message was rejected; later fragments are then ignored.
+bool ws_reassembly_begin(WsReassembly* r, bool binary, const uint8_t* data, size_t len);
+
+// Continuation fragment (WStype_FRAGMENT). Returns false if the message is rejected.
+bool ws_reassembly_append(WsReassembly* r, const uint8_t* data, size_t len);
+
+// Final fragment (WStype_FRAGMENT_FIN). Returns true and the complete message
+// if it was assembled; the data stays valid until the next ws_reassembly_begin.
+// Text messages are null-terminated.
+bool ws_reassembly_finish(WsReassembly* r, const uint8_t* data, size_t len, uint8_t** msg, size_t* msg_len);
@@ -0,0 +1,78 @@
+#include "ws_trace.h"
+#include <string.h>
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void ws_trace_init(WsTraceWriter* w, uint8_t* buf, size_t capacity) {
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->capacity = buf ? capacity : 0;
+}
+
+bool ws_trace_start(WsTraceWriter* w, uint32_t now_ms) {
+    w->len = 0;
+    w->records = 0;
+    w->overflowed = false;
+    w->recording = false;
+    if (w->capacity < WS_TRACE_HEADER_SIZE) return false;
+    memcpy(w->buf, WS_TRACE_MAGIC, 4);
+    w->buf[4] = WS_TRACE_VERSION;
+    memset(w->buf + 5, 0, 3);
+    w->len = WS_TRACE_HEADER_SIZE;
+    w->start_ms = now_ms;
+    w->recording = true;
+    return true;
+}
+
+bool ws_trace_record(WsTraceWriter* w, uint32_t now_ms, uint8_t type, const uint8_t* payload, size_t len) {
+    if (!w->recording) return false;
+    if ((uint64_t)len > UINT32_MAX || w->capacity - w->len < WS_TRACE_RECORD_HEADER_SIZE ||
+        w->capacity - w->len - WS_TRACE_RECORD_HEADER_SIZE < len) {
+        w->overflowed = true;
+        w->recording = false;
+        return false;
+    }
+    uint8_t* p = w->buf + w->len;
+    put_u32(p, now_ms - w->start_ms);
+    p[4] = type;
+    put_u32(p + 5, (uint32_t)len);
+    if (len) memcpy(p + WS_TRACE_RECORD_HEADER_SIZE, payload, len);
+    w->len += WS_TRACE_RECORD_HEADER_SIZE + len;
+    w->records++;
+    return true;
+}
+
+void ws_trace_stop(WsTraceWriter* w) {
+    w->recording = false;
+}
+
+bool ws_trace_reader_init(WsTraceReader* r, const uint8_t* data, size_t len) {
+    r->pos = r->end = data;
+    if (!data || len < WS_TRACE_HEADER_SIZE) return false;
+    if (memcmp(data, WS_TRACE_MAGIC, 4) != 0 || data[4] != WS_TRACE_VERSION) return false;
+    r->pos = data + WS_TRACE_HEADER_SIZE;
+    r->end = data + len;
+    return true;
+}
+
+bool ws_trace_next(WsTraceReader* r, WsTraceEvent* ev) {
+    size_t left = (size_t)(r->end - r->pos);
+    if (left < WS_TRACE_RECORD_HEADER_SIZE) return false;
+    uint32_t len = get_u32(r->pos + 5);
+    if (left - WS_TRACE_RECORD_HEADER_SIZE < len) return false;
+    ev->time_ms = get_u32(r->pos);
+    ev->type = r->pos[4];
+    ev->payload = r->pos + WS_TRACE_RECORD_HEADER_SIZE;
+    ev->len = len;
+    r->pos += WS_TRACE_RECORD_HEADER_SIZE + len;
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Recording of a WebSocket session: every event webSocketEvent() receives,
+// with its arrival time, in a compact binary trace. host/ws_replay.cpp feeds a
+// trace back into the same handler, so a session seen on the device can be
+// rerun on the host. A test server can also write traces directly.
+//
+// Trace format, little-endian:
+//
+//   offset size field
+//   0      4    magic 'W' 'S' 'T' 'R'
+//   4      1    version (WS_TRACE_VERSION)
+//   5      3    reserved (0)
+//
+// followed by one record per event:
+//
+//   0      4    time in ms since the recording started
+//   4      1    event type (the arduinoWebSockets WStype_t value)
+//   5      4    payload length in bytes
+//   9      ...  payload, as the handler received it
+//
+// Recording copies the payload before the handler runs, because the JSON path
+// parses the payload in place and changes it.
+
+#define WS_TRACE_MAGIC "WSTR"
+#define WS_TRACE_VERSION 1
+#define WS_TRACE_HEADER_SIZE 8
+#define WS_TRACE_RECORD_HEADER_SIZE 9
+
+// Writes a trace into a fixed, caller-provided buffer (allocated once in PSRAM)
+struct WsTraceWriter {
+    uint8_t* buf;
+    size_t capacity;
+    size_t len;         // bytes written, including the header
+    uint32_t start_ms;  // millis() when the recording started
+    uint32_t records;
+    bool recording;
+    bool overflowed;    // an event did not fit; recording stopped there
+};
+
+void ws_trace_init(WsTraceWriter* w, uint8_t* buf, size_t capacity);
+
+// Starts a new trace, dropping any previous one. Returns false if the buffer
+// cannot even hold the header.
+bool ws_trace_start(WsTraceWriter* w, uint32_t now_ms);
+
+// Appends an event if a recording is running. When the event does not fit,
+// the recording stops there (the trace stays valid up to the previous event)
+// and false is returned.
+bool ws_trace_record(WsTraceWriter* w, uint32_t now_ms, uint8_t type, const uint8_t* payload, size_t len);
+
+// Stops recording; the trace is buf[0, len)
+void ws_trace_stop(WsTraceWriter* w);
+
+struct WsTraceEvent {
+    uint32_t time_ms;
+    uint8_t type;
+    const uint8_t* payload; // Points into the trace, not aligned
+    size_t len;
+};
+
+struct WsTraceReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+};
+
+// Checks the header. Returns false if data is not a trace of this version.
+bool ws_trace_reader_init(WsTraceReader* r, const uint8_t* data, size_t len);
+
+// Reads the next event. Returns false at the end of the trace or at a
+// truncated record.
+bool ws_trace_next(WsTraceReader* r, WsTraceEvent* ev);